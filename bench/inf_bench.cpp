@@ -0,0 +1,1165 @@
+/**
+ * @file inf_bench.cpp
+ * @brief Benchmarks of the indexing and corpus components on seeded
+ *        synthetic data.
+ *
+ * `inf_bench [<benchmark>...]` runs the named benchmarks, or all of them
+ * without arguments, and prints one line per measure. Generators are
+ * seeded, so runs on the same machine are comparable. Build in Release;
+ * the numbers of a Debug build say little.
+ */
+
+#include <iostream>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <ranges>
+#include <tuple>
+#include <generator>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <expected>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <stop_token>
+#include <span>
+#include <fstream>
+#include <string_view>
+#include <exception>
+#include <utility>
+#include <chrono>
+#include <type_traits>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <charconv>
+#include <cctype>
+#include <format>
+#include <queue>
+#include <bit>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cwctype>
+#include <sstream>
+#include <system_error>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+#include <nlohmann/json.hpp>
+
+import setup_api;
+import file_io;
+
+#include "reader.h"
+#include "hardware_id.h"
+#include "report.h"
+#include "parse_limits.h"
+#include "parallel.h"
+#include "manifest.h"
+#include "snapshot.h"
+#include "corpus.h"
+#include "diff.h"
+#include "trie.h"
+#include "bloom.h"
+#include "ranking.h"
+#include "inventory.h"
+#include "planner.h"
+#include "cluster.h"
+#include "dedup.h"
+#include "incremental.h"
+#include "json.h"
+#include "pipeline.h"
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Wall time of one call, in seconds.
+     */
+    template <typename F>
+    double seconds_of(F&& operation)
+    {
+        const clock::time_point start = clock::now();
+        operation();
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    /**
+     * @brief Average wall time of a call, over as many calls as fit in a
+     *        tenth of a second, in seconds.
+     */
+    template <typename F>
+    double seconds_per_call(F&& operation)
+    {
+        static constexpr auto measured = std::chrono::milliseconds{ 100 };
+
+        size_t calls{ 0 };
+        const clock::time_point start = clock::now();
+        clock::duration elapsed{};
+        do
+        {
+            operation();
+            ++calls;
+            elapsed = clock::now() - start;
+        } while (elapsed < measured);
+
+        return std::chrono::duration<double>(elapsed).count() / static_cast<double>(calls);
+    }
+
+    /**
+     * @brief Keep a computed value alive so the loop producing it is not
+     *        optimized out.
+     */
+    void keep(std::uint64_t value) noexcept
+    {
+        static volatile std::uint64_t sink;
+        sink = sink + value;
+    }
+
+    void print_measure(std::string_view benchmark, std::string_view measure, std::string_view value)
+    {
+        std::cout << std::format("{:<10} {:<44} {}\n", benchmark, measure, value);
+    }
+
+    /**
+     * @class temporary_path
+     * @brief A file or directory under the temporary directory, removed
+     *        with its contents on destruction.
+     */
+    class temporary_path
+    {
+    public:
+        std::filesystem::path path;
+
+        explicit temporary_path(std::string_view name)
+            : path(std::filesystem::temp_directory_path() / name)
+        {
+        }
+
+        ~temporary_path()
+        {
+            std::error_code ignored;
+            std::filesystem::remove_all(path, ignored);
+        }
+
+        temporary_path(const temporary_path&) = delete;
+        temporary_path& operator=(const temporary_path&) = delete;
+    };
+
+    /**
+     * @brief Distinct, upper-case hardware IDs shaped like real ones: PCI
+     *        IDs with subsystem and revision from 16 vendors, and
+     *        USB IDs with revision. Long shared prefixes are the norm.
+     */
+    std::vector<std::string> make_hardware_ids(size_t count, std::uint64_t seed)
+    {
+        static constexpr std::array<std::uint16_t, 16> vendors{
+            0x8086, 0x10DE, 0x1002, 0x10EC, 0x14E4, 0x168C, 0x1969, 0x1B21,
+            0x1022, 0x15AD, 0x1AF4, 0x8087, 0x0BDA, 0x046D, 0x045E, 0x04F2 };
+
+        std::mt19937_64 random{ seed };
+        std::unordered_set<std::string> seen;
+        std::vector<std::string> result;
+        result.reserve(count);
+        while (result.size() < count)
+        {
+            const std::uint16_t vendor = vendors[random() % vendors.size()];
+            const std::uint64_t bits = random();
+            std::string id = bits % 10 < 7
+                ? std::format("PCI\\VEN_{:04X}&DEV_{:04X}&SUBSYS_{:08X}&REV_{:02X}",
+                    vendor, bits >> 48, (bits >> 16) & 0xFFFFFFFF, bits & 0x0F)
+                : std::format("USB\\VID_{:04X}&PID_{:04X}&REV_{:04X}",
+                    vendor, bits >> 48, (bits >> 16) & 0x0FFF);
+
+            if (seen.insert(id).second)
+            {
+                result.push_back(std::move(id));
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Distinct section names: decorated models sections and the
+     *        install sections they point to.
+     */
+    std::vector<std::string> make_section_names(size_t count)
+    {
+        static constexpr std::array<std::string_view, 4> architectures{ "NTamd64", "NTx86", "NTarm64", "NTia64" };
+        static constexpr std::array<std::string_view, 4> suffixes{ "", ".Services", ".HW", ".CoInstallers" };
+
+        std::vector<std::string> result;
+        result.reserve(count);
+        for (size_t ordinal = 0; result.size() < count; ++ordinal)
+        {
+            result.push_back(std::format("Models.{}.10.0...{}", architectures[ordinal % architectures.size()], 14310 + ordinal));
+            for (std::string_view suffix : suffixes)
+            {
+                if (result.size() < count)
+                {
+                    result.push_back(std::format("Install_{}.{}{}", ordinal, architectures[ordinal % architectures.size()], suffix));
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief A parsed corpus listing `hardware_ids` in order,
+     *        `ids_per_entry` IDs per INF in one manufacturer, four IDs per
+     *        device: one hardware ID followed by three compatible IDs.
+     */
+    corpus make_corpus(std::span<const std::string> hardware_ids, size_t ids_per_entry)
+    {
+        static constexpr size_t ids_per_device{ 4 };
+
+        corpus result;
+        result.reserve((hardware_ids.size() + ids_per_entry - 1) / ids_per_entry);
+        for (size_t first = 0; first < hardware_ids.size(); first += ids_per_entry)
+        {
+            const std::span<const std::string> ids = hardware_ids.subspan(first, std::min(ids_per_entry, hardware_ids.size() - first));
+
+            manufacturer maker{ .name = "Contoso", .devices = {} };
+            for (size_t device = 0; device < ids.size(); device += ids_per_device)
+            {
+                const std::span<const std::string> device_ids = ids.subspan(device, std::min(ids_per_device, ids.size() - device));
+                std::vector<std::string> model_ids{ device_ids.begin(), device_ids.end() };
+                std::vector<decoded_hardware_id> decoded = decode_hardware_ids(model_ids);
+                maker.devices.push_back(model{
+                    .description = std::format("Device {}", first + device),
+                    .hardware_ids = std::move(model_ids),
+                    .architectures = { "NTamd64" },
+                    .decoded_hardware_ids = std::move(decoded) });
+            }
+
+            result.push_back(corpus_entry{
+                .location = {},
+                .path = std::format("oem{}.inf", result.size()),
+                .sha256 = {},
+                .manufacturers = report{ std::move(maker) },
+                .version = std::nullopt,
+                .error = {},
+                .cancelled = false,
+                .diagnostics = {} });
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Case-insensitive keys; every other key is lowered so that the
+     *        folding path is exercised too.
+     */
+    std::vector<key_name> to_keys(std::span<const std::string> names)
+    {
+        std::vector<key_name> result;
+        result.reserve(names.size());
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            std::wstring wide = from_utf8(names[i]);
+            if (i % 2 != 0)
+            {
+                std::ranges::transform(wide, wide.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+            }
+
+            result.emplace_back(wide.data(), wide.size());
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief The `*131` polynomial the traits hashed with before, for
+     *        comparison; characters are lowered with `towlower`.
+     */
+    size_t polynomial_hash(key_name_view key) noexcept
+    {
+        size_t result{ 0 };
+        for (wchar_t c : key)
+        {
+            result = result * 131 + static_cast<size_t>(std::towlower(c));
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Throughput and collisions of one hash over one key set.
+     *
+     * Bucket collisions are counted on the low bits, as power-of-two hash
+     * tables index them, with one bucket per key rounded up; a random hash
+     * leaves `n - m (1 - (1 - 1/m)^n)` keys in an occupied bucket.
+     */
+    template <typename H>
+    void measure_hash(std::string_view set, std::string_view name, std::span<const key_name> keys, H hash)
+    {
+        static constexpr int passes{ 10 };
+
+        size_t bytes{ 0 };
+        for (const key_name& key : keys)
+        {
+            bytes += key.size() * sizeof(wchar_t);
+        }
+
+        const double seconds = seconds_of([&]
+            {
+                std::uint64_t combined{ 0 };
+                for (int pass = 0; pass < passes; ++pass)
+                {
+                    for (const key_name& key : keys)
+                    {
+                        combined += hash(key);
+                    }
+                }
+
+                keep(combined);
+            });
+
+        std::vector<std::uint64_t> values;
+        values.reserve(keys.size());
+        for (const key_name& key : keys)
+        {
+            values.push_back(hash(key));
+        }
+
+        const size_t bucket_count = std::bit_ceil(keys.size());
+        std::vector<std::uint32_t> loads(bucket_count, 0);
+        for (std::uint64_t value : values)
+        {
+            ++loads[value & (bucket_count - 1)];
+        }
+
+        const size_t occupied = static_cast<size_t>(std::ranges::count_if(loads, [](std::uint32_t load) { return load != 0; }));
+        const double n = static_cast<double>(keys.size());
+        const double m = static_cast<double>(bucket_count);
+        const double expected = n - m * (1.0 - std::pow(1.0 - 1.0 / m, n));
+
+        std::ranges::sort(values);
+        const size_t distinct = static_cast<size_t>(std::ranges::unique(values).begin() - values.begin());
+
+        print_measure("hash", std::format("{} ({}), {}", set, keys.size(), name), std::format(
+            "{:.0f} MB/s, {} full collisions, {} bucket collisions (random: {:.0f}), longest bucket {}",
+            bytes * passes / seconds / 1e6,
+            keys.size() - distinct,
+            keys.size() - occupied,
+            expected,
+            std::ranges::max(loads)));
+    }
+
+    void bench_hash()
+    {
+        const std::vector<key_name> hardware_ids = to_keys(make_hardware_ids(1'000'000, 1));
+        const std::vector<key_name> sections = to_keys(make_section_names(100'000));
+
+        for (const auto& [set, keys] : { std::pair{ "hardware IDs", &hardware_ids }, std::pair{ "section names", &sections } })
+        {
+            measure_hash(set, "folding hash", *keys, std::hash<key_name_view>{});
+            measure_hash(set, "*131 polynomial", *keys, polynomial_hash);
+        }
+    }
+
+    /**
+     * @brief Reference glob match (`*` and `?`) with single-star
+     *        backtracking.
+     */
+    bool glob_matches(std::string_view pattern, std::string_view text) noexcept
+    {
+        size_t position{ 0 };
+        size_t offset{ 0 };
+        size_t star{ std::string_view::npos };
+        size_t resume{ 0 };
+        while (offset < text.size())
+        {
+            if (position < pattern.size() && (pattern[position] == '?' || pattern[position] == text[offset]))
+            {
+                ++position;
+                ++offset;
+            }
+            else if (position < pattern.size() && pattern[position] == '*')
+            {
+                star = position++;
+                resume = offset;
+            }
+            else if (star != std::string_view::npos)
+            {
+                position = star + 1;
+                offset = ++resume;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (position < pattern.size() && pattern[position] == '*')
+        {
+            ++position;
+        }
+
+        return position == pattern.size();
+    }
+
+    /**
+     * @brief Trie build time and query latency over 1M distinct IDs in 10k
+     *        INFs, against a scan of every report folding each ID.
+     */
+    void bench_trie()
+    {
+        const std::vector<std::string> hardware_ids = make_hardware_ids(1'000'000, 2);
+        const corpus entries = make_corpus(hardware_ids, 100);
+
+        std::optional<hardware_id_trie> trie;
+        const double build = seconds_of([&] { trie.emplace(build_hardware_id_trie(entries)); });
+        print_measure("trie", std::format("build ({} IDs, {} INFs)", hardware_ids.size(), entries.size()), std::format("{:.2f} s", build));
+
+        // a device prefix that exists: the first PCI ID up to its subsystem
+        const std::string& pci = *std::ranges::find_if(hardware_ids, [](const std::string& id) { return id.starts_with("PCI"); });
+        const std::string device_prefix = pci.substr(0, pci.find("&SUBSYS_")) + '*';
+
+        const std::array<std::pair<std::string_view, std::string>, 5> queries{ {
+            { "vendor prefix", "PCI\\VEN_8086&DEV_*" },
+            { "device prefix", device_prefix },
+            { "USB vendor glob", "USB\\VID_0BDA&PID_*&REV_0??1" },
+            { "inner wildcards", "PCI\\VEN_*&DEV_00?0*" },
+            { "no match", "ACPI\\PNP0A08*" } } };
+
+        for (const auto& [name, pattern] : queries)
+        {
+            const std::string folded = fold_key(pattern);
+
+            size_t found{ 0 };
+            const double trie_time = seconds_per_call([&]
+                {
+                    found = 0;
+                    trie->find_matching(folded, [&found](std::string_view, std::span<const hardware_id_posting>) { ++found; });
+                });
+
+            size_t scanned{ 0 };
+            const double scan_time = seconds_of([&]
+                {
+                    for (const corpus_entry& entry : entries)
+                    {
+                        for (const manufacturer& maker : *entry.manufacturers)
+                        {
+                            for (const model& device : maker.devices)
+                            {
+                                for (const std::string& hardware_id : device.hardware_ids)
+                                {
+                                    scanned += glob_matches(folded, fold_key(hardware_id)) ? 1 : 0;
+                                }
+                            }
+                        }
+                    }
+                });
+
+            if (found != scanned)
+            {
+                throw std::logic_error(std::format("The trie found {} IDs for '{}', the scan {}", found, pattern, scanned));
+            }
+
+            print_measure("trie", std::format("{} ({} IDs)", name, found), std::format(
+                "{:.3f} ms, scan {:.1f} ms (x{:.0f})", trie_time * 1e3, scan_time * 1e3, scan_time / trie_time));
+        }
+
+        // exact lookups of random present IDs
+        static constexpr size_t lookups{ 100'000 };
+        std::mt19937_64 random{ 3 };
+        std::vector<std::string> keys;
+        keys.reserve(lookups);
+        for (size_t i = 0; i < lookups; ++i)
+        {
+            keys.push_back(fold_key(hardware_ids[random() % hardware_ids.size()]));
+        }
+
+        size_t postings{ 0 };
+        const double lookup_time = seconds_of([&]
+            {
+                for (const std::string& key : keys)
+                {
+                    postings += trie->find(key).size();
+                }
+            });
+
+        print_measure("trie", std::format("exact lookups ({})", lookups), std::format(
+            "{:.2f} us each, {} postings", lookup_time / lookups * 1e6, postings));
+    }
+
+    /**
+     * @brief Bloom filter build and probe costs, false-positive rate, and
+     *        `match_corpus_index` against a full decode of a `--batch`
+     *        index of 80k INFs with 12 IDs each.
+     */
+    void bench_bloom()
+    {
+        const std::vector<std::string> hardware_ids = make_hardware_ids(960'000, 4);
+        const corpus entries = make_corpus(hardware_ids, 12);
+
+        std::string index_text;
+        index_fingerprint fingerprint;
+        for (const corpus_entry& entry : entries)
+        {
+            const std::string line = nlohmann::json(entry).dump();
+            fingerprint.add(line);
+            index_text += line;
+            index_text += '\n';
+        }
+
+        std::vector<blocked_bloom_filter> filters;
+        filters.reserve(entries.size());
+        const double build = seconds_of([&]
+            {
+                for (const corpus_entry& entry : entries)
+                {
+                    filters.push_back(build_bloom_filter(entry));
+                }
+            });
+
+        const temporary_path sidecar_path{ "inf_bench.bloom" };
+        write_bloom_sidecar(sidecar_path.path, filters, fingerprint);
+        const bloom_sidecar sidecar{ sidecar_path.path };
+
+        print_measure("bloom", std::format("build ({} INFs, {} IDs)", entries.size(), hardware_ids.size()), std::format(
+            "{:.0f} ms, sidecar {:.1f} MB, index {:.0f} MB",
+            build * 1e3,
+            static_cast<double>(std::filesystem::file_size(sidecar_path.path)) / 1e6,
+            static_cast<double>(index_text.size()) / 1e6));
+
+        // absent IDs against every filter: the false-positive rate per probe
+        static constexpr size_t absent_count{ 1'000 };
+        std::vector<bloom_probe> absent;
+        absent.reserve(absent_count);
+        for (size_t i = 0; i < absent_count; ++i)
+        {
+            absent.push_back(make_bloom_probe(bloom_hash(fold_key(std::format("ACPI\\VEN_CTSO&DEV_{:04X}", i)))));
+        }
+
+        size_t positives{ 0 };
+        const double probe = seconds_of([&]
+            {
+                for (size_t i = 0; i < sidecar.size(); ++i)
+                {
+                    const std::span<const bloom_block> filter = sidecar.filter(i);
+                    for (const bloom_probe& item : absent)
+                    {
+                        positives += bloom_may_contain(filter, item) ? 1 : 0;
+                    }
+                }
+            });
+
+        const size_t probes = absent.size() * sidecar.size();
+        print_measure("bloom", std::format("absent probes ({})", probes), std::format(
+            "{:.2f} ns each, false-positive rate {:.3f}%",
+            probe / static_cast<double>(probes) * 1e9,
+            100.0 * static_cast<double>(positives) / static_cast<double>(probes)));
+
+        std::vector<std::string> absent_ids;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            absent_ids.push_back(std::format("PCI\\VEN_CTSO&DEV_{:04X}", i));
+        }
+
+        const std::array<std::pair<std::string_view, std::vector<std::string>>, 3> queries{ {
+            { "1 present ID", { hardware_ids[123'457] } },
+            { "device, 2 of 4 IDs present", { hardware_ids[500'001], hardware_ids[700'003], "PCI\\VEN_CTSO&CC_0300", "PCI\\CC_0300" } },
+            { "16 absent IDs", absent_ids } } };
+
+        for (const auto& [name, query] : queries)
+        {
+            std::unordered_set<std::string> folded;
+            for (const std::string& hardware_id : query)
+            {
+                folded.insert(fold_key(hardware_id));
+            }
+
+            std::istringstream filtered_index{ index_text };
+            size_t matches{ 0 };
+            const bloom_match_statistics statistics = match_corpus_index(
+                filtered_index,
+                sidecar,
+                query,
+                [&matches](const index_match&) { ++matches; });
+
+            std::istringstream full_index{ index_text };
+            size_t decoded_matches{ 0 };
+            const double full_decode = seconds_of([&]
+                {
+                    std::string text;
+                    while (std::getline(full_index, text))
+                    {
+                        const corpus_entry entry = parse_corpus_index_line(text);
+                        for (const manufacturer& maker : *entry.manufacturers)
+                        {
+                            for (const model& device : maker.devices)
+                            {
+                                for (const std::string& hardware_id : device.hardware_ids)
+                                {
+                                    decoded_matches += folded.contains(fold_key(hardware_id)) ? 1 : 0;
+                                }
+                            }
+                        }
+                    }
+                });
+
+            if (matches != decoded_matches)
+            {
+                throw std::logic_error(std::format("--match found {} occurrences for '{}', a full decode {}", matches, name, decoded_matches));
+            }
+
+            using milliseconds = std::chrono::duration<double, std::milli>;
+            const double filtered = milliseconds{ statistics.probe_time + statistics.decode_time }.count();
+            print_measure("bloom", std::format("{} ({} matches)", name, matches), std::format(
+                "{} candidates, {:.1f} ms (probe {:.1f} ms), full decode {:.0f} ms (x{:.0f})",
+                statistics.candidates,
+                filtered,
+                milliseconds{ statistics.probe_time }.count(),
+                full_decode * 1e3,
+                full_decode * 1e3 / filtered));
+        }
+    }
+
+    /**
+     * @brief `ranking_index::rank` throughput over 20k INFs where every ID
+     *        is listed by 5 packages of differing signature, date and
+     *        version, as successive driver releases are.
+     */
+    void bench_rank()
+    {
+        static constexpr size_t releases{ 5 };
+
+        const std::vector<std::string> distinct_ids = make_hardware_ids(200'000, 5);
+        std::mt19937_64 random{ 6 };
+        std::vector<std::string> hardware_ids;
+        hardware_ids.reserve(distinct_ids.size() * releases);
+        for (size_t release = 0; release < releases; ++release)
+        {
+            std::vector<std::string> shuffled = distinct_ids;
+            std::ranges::shuffle(shuffled, random);
+            std::ranges::move(shuffled, std::back_inserter(hardware_ids));
+        }
+
+        corpus entries = make_corpus(hardware_ids, 50);
+        for (corpus_entry& entry : entries)
+        {
+            const std::uint64_t bits = random();
+            entry.version = package_version{
+                .class_name = "System",
+                .provider = "Contoso",
+                .catalog_file = bits % 4 != 0 ? "contoso.cat" : "",
+                .driver_date = std::format("{:02}/{:02}/{}", 1 + (bits >> 8) % 12, 1 + (bits >> 16) % 28, 2015 + (bits >> 24) % 10),
+                .driver_version = std::format("10.0.{}.{}", (bits >> 32) % 30000, (bits >> 48) % 100) };
+        }
+
+        std::optional<ranking_index> index;
+        const double build = seconds_of([&] { index.emplace(entries); });
+        print_measure("rank", std::format("index ({} INFs, {} IDs)", entries.size(), hardware_ids.size()), std::format("{:.0f} ms", build * 1e3));
+
+        // devices report the listed ID first, then less specific forms of
+        // it that no package lists; compatible IDs are generic
+        static constexpr size_t device_count{ 100'000 };
+        std::vector<std::pair<std::vector<std::string>, std::vector<std::string>>> devices;
+        devices.reserve(device_count);
+        for (size_t i = 0; i < device_count; ++i)
+        {
+            const std::string& hardware_id = distinct_ids[random() % distinct_ids.size()];
+            const std::string prefix = hardware_id.substr(0, hardware_id.find("&REV_"));
+            devices.emplace_back(
+                std::vector<std::string>{ hardware_id, prefix },
+                std::vector<std::string>{ prefix.substr(0, prefix.find('&')), "PCI\\CC_0300" });
+        }
+
+        const platform_decoration platform = *parse_platform_decoration("NTamd64.10.0...19041");
+
+        size_t candidates{ 0 };
+        const double ranking = seconds_of([&]
+            {
+                for (const auto& [device_hardware_ids, device_compatible_ids] : devices)
+                {
+                    const std::vector<ranked_driver> ranked = index->rank(device_hardware_ids, device_compatible_ids, platform);
+                    candidates += ranked.size();
+                    keep(ranked.empty() ? 0 : ranked.front().rank);
+                }
+            });
+
+        print_measure("rank", std::format("devices ({})", device_count), std::format(
+            "{:.0f} ranks/s, {:.2f} us each, {:.1f} candidates per device",
+            device_count / ranking,
+            ranking / device_count * 1e6,
+            static_cast<double>(candidates) / device_count));
+    }
+
+    /**
+     * @brief The JSON Lines inventory of `machine_count` machines. Device
+     *        model `i` reports `model_ids[i]` and its form without revision
+     *        as hardware IDs, and generic compatible IDs; the first devices
+     *        are one of each model, the others drawn at random.
+     */
+    std::string make_inventory(
+        std::span<const std::string> model_ids,
+        size_t machine_count,
+        size_t devices_per_machine,
+        std::mt19937_64& random)
+    {
+        std::vector<nlohmann::json> models;
+        models.reserve(model_ids.size());
+        for (const std::string& hardware_id : model_ids)
+        {
+            const std::string prefix = hardware_id.substr(0, hardware_id.find("&REV_"));
+            models.push_back(nlohmann::json{
+                { "hardware_ids", { hardware_id, prefix } },
+                { "compatible_ids", { prefix.substr(0, prefix.find('&')), "PCI\\CC_0300" } } });
+        }
+
+        std::string result;
+        for (size_t machine = 0; machine < machine_count; ++machine)
+        {
+            nlohmann::json devices = nlohmann::json::array();
+            for (size_t device = 0; device < devices_per_machine; ++device)
+            {
+                const size_t ordinal = machine * devices_per_machine + device;
+                nlohmann::json item = models[ordinal < models.size() ? ordinal : random() % models.size()];
+                item["id"] = std::format("ROOT\\DEVICE\\{:04}", device);
+                devices.push_back(std::move(item));
+            }
+
+            result += nlohmann::json{ { "machine", std::format("PC-{:05}", machine) }, { "devices", std::move(devices) } }.dump();
+            result += '\n';
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Inventory join stages over 50k machines of 20 devices each,
+     *        drawn from 5k device models, against 10k INFs with 1M IDs;
+     *        the join is compared to a trie lookup of every device ID.
+     */
+    void bench_inventory()
+    {
+        static constexpr size_t machine_count{ 50'000 };
+        static constexpr size_t devices_per_machine{ 20 };
+        static constexpr size_t device_models{ 5'000 };
+
+        const std::vector<std::string> hardware_ids = make_hardware_ids(1'000'000, 7);
+        const corpus entries = make_corpus(hardware_ids, 100);
+
+        // 7 in 10 device models have a driver in the corpus; the others
+        // report IDs no INF lists
+        std::mt19937_64 random{ 8 };
+        std::vector<std::string> model_ids;
+        model_ids.reserve(device_models);
+        for (size_t i = 0; i < device_models; ++i)
+        {
+            model_ids.push_back(i % 10 < 7
+                ? hardware_ids[random() % hardware_ids.size()]
+                : std::format("ACPI\\CTSO{:05X}", i));
+        }
+
+        const std::string inventory_text = make_inventory(model_ids, machine_count, devices_per_machine, random);
+
+        std::optional<inventory> fleet;
+        const double read = seconds_of([&]
+            {
+                std::istringstream input{ inventory_text };
+                fleet.emplace(read_inventory(input));
+            });
+
+        std::optional<hardware_id_dictionary> dictionary;
+        const double dictionary_time = seconds_of([&] { dictionary.emplace(build_hardware_id_dictionary(entries)); });
+
+        std::optional<inventory_join> join;
+        const double intersect = seconds_of([&] { join.emplace(*fleet, entries, *dictionary); });
+
+        size_t covered{ 0 };
+        const double fan_out = seconds_of([&]
+            {
+                for (const inventory_machine& machine : fleet->machines)
+                {
+                    covered += join->cover(machine).covered;
+                }
+            });
+
+        const size_t device_count = machine_count * devices_per_machine;
+        print_measure("inventory", std::format("read ({} machines, {} devices)", machine_count, device_count), std::format(
+            "{:.0f} ms, {} distinct IDs, {:.0f} MB", read * 1e3, fleet->keys.size(), static_cast<double>(inventory_text.size()) / 1e6));
+        print_measure("inventory", std::format("dictionary ({} INFs, {} IDs)", entries.size(), hardware_ids.size()), std::format(
+            "{:.0f} ms", dictionary_time * 1e3));
+        print_measure("inventory", "intersect", std::format(
+            "{:.2f} ms, {} IDs matched", intersect * 1e3, join->matched_keys()));
+        print_measure("inventory", "cover every machine", std::format(
+            "{:.0f} ms, {} devices covered", fan_out * 1e3, covered));
+
+        // the per-device alternative: look up each ID of each device until
+        // one is in the corpus
+        const hardware_id_trie trie = build_hardware_id_trie(entries);
+        size_t looked_up{ 0 };
+        const double lookup = seconds_of([&]
+            {
+                for (const inventory_machine& machine : fleet->machines)
+                {
+                    for (const inventory_device& device : machine.devices)
+                    {
+                        for (const auto* list : { &device.hardware_ids, &device.compatible_ids })
+                        {
+                            if (std::ranges::any_of(*list, [&trie](const std::string& id) { return !trie.find(fold_key(id)).empty(); }))
+                            {
+                                ++looked_up;
+                                break;
+                            }
+                        }
+                    }
+                }
+            });
+
+        if (looked_up != covered)
+        {
+            throw std::logic_error(std::format("The join covered {} devices, per-device lookups {}", covered, looked_up));
+        }
+
+        print_measure("inventory", "per-device trie lookups", std::format(
+            "{:.0f} ms (join x{:.1f})", lookup * 1e3, lookup / (intersect + fan_out)));
+    }
+
+    /**
+     * @brief Coverage matrix and greedy set cover for 10k packages and 100k
+     *        distinct devices: 200k devices on 1k machines, where 17 in 20
+     *        device models are listed by 5 releases of a driver.
+     *
+     * Packages either list related IDs, as real ones list one device
+     * family, with each release shifted by a fifth of a package so releases
+     * overlap without being identical; or IDs scattered over all vendors,
+     * which makes every coverage row span nearly all devices.
+     */
+    void bench_plan()
+    {
+        static constexpr size_t releases{ 5 };
+        static constexpr size_t ids_per_entry{ 100 };
+        static constexpr size_t device_models{ 100'000 };
+        static constexpr size_t machine_count{ 1'000 };
+        static constexpr size_t devices_per_machine{ 200 };
+
+        std::vector<std::string> distinct_ids = make_hardware_ids(200'000, 9);
+        std::mt19937_64 random{ 10 };
+        std::ranges::shuffle(distinct_ids, random);
+
+        std::vector<std::string> model_ids;
+        model_ids.reserve(device_models);
+        for (size_t i = 0; i < device_models; ++i)
+        {
+            model_ids.push_back(i % 20 < 17 ? distinct_ids[i] : std::format("ACPI\\CTSO{:05X}", i));
+        }
+
+        std::istringstream input{ make_inventory(model_ids, machine_count, devices_per_machine, random) };
+        const inventory fleet = read_inventory(input);
+
+        std::vector<std::string> sorted_ids = distinct_ids;
+        std::ranges::sort(sorted_ids);
+
+        for (const bool scattered : { false, true })
+        {
+            std::vector<std::string> hardware_ids;
+            hardware_ids.reserve(distinct_ids.size() * releases);
+            for (size_t release = 0; release < releases; ++release)
+            {
+                if (scattered)
+                {
+                    std::vector<std::string> shuffled = distinct_ids;
+                    std::ranges::shuffle(shuffled, random);
+                    std::ranges::move(shuffled, std::back_inserter(hardware_ids));
+                }
+                else
+                {
+                    std::ranges::rotate_copy(
+                        sorted_ids,
+                        sorted_ids.begin() + static_cast<ptrdiff_t>(release * ids_per_entry / releases),
+                        std::back_inserter(hardware_ids));
+                }
+            }
+
+            const corpus entries = make_corpus(hardware_ids, ids_per_entry);
+            const hardware_id_dictionary dictionary = build_hardware_id_dictionary(entries);
+            const std::string_view layout = scattered ? "scattered" : "related";
+
+            std::optional<coverage_matrix> matrix;
+            const double build = seconds_of([&] { matrix.emplace(build_coverage_matrix(fleet, dictionary)); });
+
+            size_t matrix_words{ 0 };
+            for (const coverage_row& row : matrix->rows)
+            {
+                matrix_words += row.words.size();
+            }
+
+            print_measure("plan", std::format("{} matrix ({} packages x {})", layout, matrix->rows.size(), matrix->devices.size()), std::format(
+                "{:.0f} ms, {:.1f} MB of rows (dense {:.0f} MB)",
+                build * 1e3,
+                static_cast<double>(matrix_words * sizeof(std::uint64_t)) / 1e6,
+                static_cast<double>(entries.size() * ((matrix->devices.size() + 63) / 64) * sizeof(std::uint64_t)) / 1e6));
+
+            std::optional<driver_plan> plan;
+            const double cover = seconds_of([&] { plan.emplace(plan_driver_set(*matrix, entries)); });
+
+            // every device the join cannot cover must be left uncovered,
+            // and only those
+            const inventory_join join{ fleet, entries, dictionary };
+            size_t coverable{ 0 };
+            for (const inventory_machine& machine : fleet.machines)
+            {
+                coverable += join.cover(machine).covered;
+            }
+
+            size_t uncovered{ 0 };
+            for (const uncovered_device& device : plan->uncovered)
+            {
+                uncovered += device.instances;
+            }
+
+            if (coverable + uncovered != machine_count * devices_per_machine)
+            {
+                throw std::logic_error(std::format("The plan leaves {} devices uncovered, the join covers {}", uncovered, coverable));
+            }
+
+            print_measure("plan", std::format("{} greedy set cover", layout), std::format(
+                "{:.0f} ms, {} packages, {} distinct devices uncovered",
+                cover * 1e3,
+                plan->packages.size(),
+                plan->uncovered.size()));
+        }
+    }
+
+    /**
+     * @brief A small, valid INF with one device per hardware ID.
+     */
+    std::string make_inf_text(size_t ordinal, std::span<const std::string> hardware_ids)
+    {
+        std::string result = std::format(
+            "[Version]\r\n"
+            "Signature=\"$Windows NT$\"\r\n"
+            "Class=System\r\n"
+            "Provider=%Mfg%\r\n"
+            "CatalogFile=oem{0}.cat\r\n"
+            "DriverVer=06/21/2024,10.0.{0}.1\r\n"
+            "\r\n"
+            "[Manufacturer]\r\n"
+            "%Mfg%=Models,NTamd64\r\n"
+            "\r\n"
+            "[Models.NTamd64]\r\n",
+            ordinal);
+
+        for (size_t device = 0; device < hardware_ids.size(); ++device)
+        {
+            result += std::format("%Device{}%=Install,{}\r\n", device, hardware_ids[device]);
+        }
+
+        result += "\r\n[Install.NTamd64]\r\nCopyFiles=Files\r\n\r\n[Files]\r\ncontoso.sys\r\n\r\n[Strings]\r\nMfg=\"Contoso\"\r\n";
+        for (size_t device = 0; device < hardware_ids.size(); ++device)
+        {
+            result += std::format("Device{}=\"Contoso Device {}\"\r\n", device, device);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Read stage of `--batch` on a tree of 50k small INFs: mapped
+     *        reads one at a time against I/O ring reads at several depths,
+     *        each hashing every file, then the whole pipeline.
+     *
+     * The tree has just been written, so reads come from the page cache;
+     * this measures the per-file system call overhead, not the disk.
+     */
+    void bench_read()
+    {
+        static constexpr size_t file_count{ 50'000 };
+        static constexpr size_t directories{ 100 };
+
+        const std::vector<std::string> hardware_ids = make_hardware_ids(file_count * 8 + 16, 11);
+        const temporary_path tree{ "inf_bench_tree" };
+
+        std::mt19937_64 random{ 12 };
+        size_t bytes{ 0 };
+        const double write = seconds_of([&]
+            {
+                for (size_t directory = 0; directory < directories; ++directory)
+                {
+                    std::filesystem::create_directories(tree.path / std::format("{:02}", directory));
+                }
+
+                for (size_t file = 0; file < file_count; ++file)
+                {
+                    // 1 to 15 devices, 8 on average
+                    const std::string text = make_inf_text(
+                        file,
+                        std::span{ hardware_ids }.subspan(file * 8, 1 + random() % 15));
+
+                    std::ofstream output{ tree.path / std::format("{:02}", file % directories) / std::format("oem{}.inf", file), std::ios::binary };
+                    output.write(text.data(), static_cast<std::streamsize>(text.size()));
+                    if (!output)
+                    {
+                        throw std::runtime_error("Failed to write a benchmark INF");
+                    }
+
+                    bytes += text.size();
+                }
+            });
+
+        const std::vector<inf_listing> files = list_inf_files(tree.path);
+        print_measure("read", std::format("write tree ({} INFs)", files.size()), std::format(
+            "{:.1f} s, {:.0f} MB", write, static_cast<double>(bytes) / 1e6));
+
+        auto report_reads = [&files](std::string_view name, double seconds)
+            {
+                print_measure("read", name, std::format(
+                    "{:.0f} ms, {:.1f} us per file, {:.0f} files/s",
+                    seconds * 1e3,
+                    seconds / static_cast<double>(files.size()) * 1e6,
+                    static_cast<double>(files.size()) / seconds));
+            };
+
+        const double mapped = seconds_of([&]
+            {
+                for (const inf_listing& file : files)
+                {
+                    const mapped_file content{ file.path };
+                    keep(sha256(content.contents()).front());
+                }
+            });
+
+        report_reads("mapped + SHA-256, one at a time", mapped);
+
+        if (!io_ring_reader::is_supported())
+        {
+            print_measure("read", "I/O ring", "not supported on this Windows version");
+        }
+        else
+        {
+            for (const std::uint32_t depth : { 16u, 64u, 256u })
+            {
+                io_ring_reader ring{ depth, pipeline_settings{}.ring_buffer_size };
+
+                size_t completed{ 0 };
+                auto hash = [&completed](const io_ring_completion& done)
+                    {
+                        if (done.failed)
+                        {
+                            throw std::runtime_error("An I/O ring read failed");
+                        }
+
+                        keep(sha256(done.contents).front());
+                        ++completed;
+                    };
+
+                const double ring_time = seconds_of([&]
+                    {
+                        size_t next{ 0 };
+                        while (next < files.size() || ring.in_flight() != 0)
+                        {
+                            for (; next < files.size() && !ring.full(); ++next)
+                            {
+                                if (!ring.submit(next, files[next].path))
+                                {
+                                    throw std::logic_error("A benchmark INF is larger than an I/O ring buffer");
+                                }
+                            }
+
+                            ring.complete(hash);
+                        }
+                    });
+
+                if (completed != files.size())
+                {
+                    throw std::logic_error(std::format("The I/O ring completed {} of {} reads", completed, files.size()));
+                }
+
+                report_reads(std::format("I/O ring + SHA-256, depth {}", depth), ring_time);
+            }
+        }
+
+        // the whole batch scan, parses included
+        size_t lines{ 0 };
+        std::optional<pipeline_statistics> statistics;
+        const double pipeline = seconds_of([&]
+            {
+                statistics = run_batch_pipeline(tree.path, files, std::nullopt, false, pipeline_settings{}, [&lines](batch_line&) { ++lines; });
+            });
+
+        if (lines != files.size())
+        {
+            throw std::logic_error(std::format("The pipeline wrote {} lines for {} INFs", lines, files.size()));
+        }
+
+        report_reads(std::format("--batch pipeline ({})", statistics->io_ring ? "I/O rings" : "mapped reads"), pipeline);
+    }
+
+    /**
+     * @class benchmark
+     * @brief A named benchmark.
+     */
+    class benchmark
+    {
+    public:
+        std::string_view name;
+        std::string_view description;
+        void (*run)();
+    };
+
+    constexpr std::array benchmarks{
+        benchmark{ .name = "hash", .description = "case-insensitive key hash: throughput and collisions", .run = bench_hash },
+        benchmark{ .name = "trie", .description = "hardware-ID trie: build time, prefix and glob query latency", .run = bench_trie },
+        benchmark{ .name = "bloom", .description = "Bloom filters: false-positive rate and --match speedup over a full decode", .run = bench_bloom },
+        benchmark{ .name = "rank", .description = "driver ranking: devices ranked per second", .run = bench_rank },
+        benchmark{ .name = "inventory", .description = "fleet inventory join: read, intersect and cover stages", .run = bench_inventory },
+        benchmark{ .name = "plan", .description = "driver-set planner: coverage matrix and greedy set cover", .run = bench_plan },
+        benchmark{ .name = "read", .description = "batch read stage: mapped reads against I/O rings on 50k INFs", .run = bench_read },
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const std::vector<std::string_view> selected(argv + 1, argv + argc);
+        for (std::string_view name : selected)
+        {
+            if (!std::ranges::contains(benchmarks, name, &benchmark::name))
+            {
+                std::cerr << std::format("Unknown benchmark '{}'. Benchmarks:\n", name);
+                for (const benchmark& item : benchmarks)
+                {
+                    std::cerr << std::format("  {:<10} {}\n", item.name, item.description);
+                }
+
+                return 1;
+            }
+        }
+
+        for (const benchmark& item : benchmarks)
+        {
+            if (selected.empty() || std::ranges::contains(selected, item.name))
+            {
+                item.run();
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,594 @@
+/**
+ * @file bloom.h
+ * @brief Per-INF blocked Bloom filters over folded hardware IDs, stored in
+ *        a sidecar next to a `--batch` index.
+ *
+ * Each filter is an array of 256-bit blocks. A key selects one block from
+ * the upper half of its hash and sets one bit in each of the block's eight
+ * 32-bit words from the lower half, so a probe touches a single cache line
+ * and compares it with two SSE2 operations.
+ *
+ * Sidecar layout (native little-endian, 32-byte aligned tables):
+ *
+ * ```
+ * bloom_sidecar_header
+ * bloom_filter_record[entry_count]     padded to 32 bytes
+ * bloom_block[block_count]
+ * ```
+ *
+ * Filter `i` belongs to the `i`-th (non-blank) line of the index. The
+ * header records the number of index lines and a SHA-256 of their text, so
+ * `--match` rejects a sidecar paired with a regenerated or edited index
+ * instead of silently missing matches. Key hashes are computed by
+ * `bloom_hash` alone, which does not depend on the standard library.
+ */
+
+/**
+ * @class bloom_block
+ * @brief One 256-bit block: eight 32-bit words.
+ */
+class alignas(32) bloom_block
+{
+public:
+    std::array<std::uint32_t, 8> words;
+};
+
+static_assert(sizeof(bloom_block) == 32 && std::is_trivially_copyable_v<bloom_block>);
+
+/**
+ * @class bloom_probe
+ * @brief Precomputed probe of one key: the block selector and the bit of
+ *        each word. Independent of the filter size.
+ */
+class bloom_probe
+{
+public:
+    std::uint32_t selector;
+    bloom_block mask;
+};
+
+/**
+ * @brief Hash a folded hardware ID for the filters.
+ *
+ * The hash is persisted in sidecars, so it is fixed rather than
+ * `std::hash`, whose values may differ between standard libraries: 64-bit
+ * FNV-1a, finalized with the SplitMix64 mixer so that both halves of the
+ * result are well distributed.
+ */
+std::uint64_t bloom_hash(std::string_view folded) noexcept
+{
+    std::uint64_t value{ 0xCBF29CE484222325ull };
+    for (const char c : folded)
+    {
+        value = (value ^ static_cast<std::uint8_t>(c)) * 0x100000001B3ull;
+    }
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Compute the probe of a key hash.
+ */
+bloom_probe make_bloom_probe(std::uint64_t hash) noexcept
+{
+    static constexpr std::array<std::uint32_t, 8> salts{
+        0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+        0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u };
+
+    const std::uint32_t key = static_cast<std::uint32_t>(hash);
+
+    bloom_probe result{ .selector = static_cast<std::uint32_t>(hash >> 32), .mask = {} };
+    for (size_t i = 0; i < salts.size(); ++i)
+    {
+        result.mask.words[i] = std::uint32_t{ 1 } << ((key * salts[i]) >> 27);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Index of the block a probe selects in a filter of `block_count`
+ *        blocks; multiply-shift instead of a modulo.
+ */
+constexpr size_t select_bloom_block(const bloom_probe& probe, size_t block_count) noexcept
+{
+    return static_cast<size_t>((std::uint64_t{ probe.selector } * block_count) >> 32);
+}
+
+/**
+ * @brief Test whether every bit of the probe mask is set in the block.
+ */
+bool bloom_block_contains(const bloom_block& block, const bloom_block& mask) noexcept
+{
+#if defined(_M_X64) || defined(_M_IX86)
+    const __m128i* block_words = reinterpret_cast<const __m128i*>(block.words.data());
+    const __m128i* mask_words = reinterpret_cast<const __m128i*>(mask.words.data());
+
+    // bits of the mask that are clear in the block
+    const __m128i missing = _mm_or_si128(
+        _mm_andnot_si128(_mm_load_si128(block_words), _mm_load_si128(mask_words)),
+        _mm_andnot_si128(_mm_load_si128(block_words + 1), _mm_load_si128(mask_words + 1)));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#else
+    std::uint32_t missing{ 0 };
+    for (size_t i = 0; i < block.words.size(); ++i)
+    {
+        missing |= mask.words[i] & ~block.words[i];
+    }
+
+    return missing == 0;
+#endif
+}
+
+/**
+ * @brief Test a filter given as its blocks. An empty filter (an INF without
+ *        hardware IDs, or one that failed to parse) contains nothing.
+ */
+bool bloom_may_contain(std::span<const bloom_block> blocks, const bloom_probe& probe) noexcept
+{
+    return !blocks.empty() && bloom_block_contains(blocks[select_bloom_block(probe, blocks.size())], probe.mask);
+}
+
+/**
+ * @class blocked_bloom_filter
+ * @brief In-memory filter under construction.
+ *
+ * Sized for about 12 bits per key, which keeps the false-positive rate
+ * below 1% for this block layout.
+ */
+class blocked_bloom_filter
+{
+private:
+    static constexpr size_t bits_per_key{ 12 };
+
+    std::vector<bloom_block> blocks;
+    std::uint32_t keys{ 0 };
+
+public:
+    explicit blocked_bloom_filter(std::uint32_t expected_keys)
+        : blocks((size_t{ expected_keys } * bits_per_key + 255) / 256, bloom_block{})
+    {
+    }
+
+    void insert(std::uint64_t hash) noexcept
+    {
+        if (blocks.empty())
+        {
+            return;
+        }
+
+        const bloom_probe probe = make_bloom_probe(hash);
+        bloom_block& block = blocks[select_bloom_block(probe, blocks.size())];
+        for (size_t i = 0; i < block.words.size(); ++i)
+        {
+            block.words[i] |= probe.mask.words[i];
+        }
+
+        ++keys;
+    }
+
+    std::span<const bloom_block> contents() const noexcept
+    {
+        return blocks;
+    }
+
+    std::uint32_t key_count() const noexcept
+    {
+        return keys;
+    }
+};
+
+/**
+ * @brief Build the filter of a corpus entry from its distinct folded
+ *        hardware and compatible IDs.
+ */
+blocked_bloom_filter build_bloom_filter(const corpus_entry& entry)
+{
+    std::unordered_set<std::string> folded;
+    if (entry.manufacturers.has_value())
+    {
+        for (const manufacturer& maker : *entry.manufacturers)
+        {
+            for (const model& device : maker.devices)
+            {
+                for (const std::string& hardware_id : device.hardware_ids)
+                {
+                    folded.insert(fold_key(hardware_id));
+                }
+            }
+        }
+    }
+
+    if (folded.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::range_error("Too many hardware IDs for a Bloom filter");
+    }
+
+    blocked_bloom_filter result{ static_cast<std::uint32_t>(folded.size()) };
+    for (const std::string& key : folded)
+    {
+        result.insert(bloom_hash(key));
+    }
+
+    return result;
+}
+
+/**
+ * @class index_fingerprint
+ * @brief Number of lines and SHA-256 of the text of a `--batch` index, fed
+ *        one line at a time as it is written or read back.
+ *
+ * Blank lines and line terminators are left out, so the fingerprint does
+ * not change when stdout translates `\n` to `\r\n`.
+ */
+class index_fingerprint
+{
+private:
+    sha256_hasher hasher;
+    std::uint64_t lines{ 0 };
+
+public:
+    void add(std::string_view line)
+    {
+        if (is_blank_index_line(line))
+        {
+            return;
+        }
+
+        if (line.ends_with('\r'))
+        {
+            line.remove_suffix(1);
+        }
+
+        static constexpr std::byte separator{ '\n' };
+        hasher.update(std::as_bytes(std::span{ line }));
+        hasher.update(std::span{ &separator, 1 });
+        ++lines;
+    }
+
+    std::uint64_t entries() const noexcept
+    {
+        return lines;
+    }
+
+    sha256_digest finish()
+    {
+        return hasher.finish();
+    }
+};
+
+/**
+ * @class bloom_sidecar_header
+ * @brief Fixed-size sidecar header. `entry_count` and `index_digest` are
+ *        the `index_fingerprint` of the index the filters were built for.
+ */
+class bloom_sidecar_header
+{
+public:
+    static constexpr std::array<char, 4> expected_magic{ 'I', 'N', 'F', 'B' };
+    static constexpr std::uint32_t current_version{ 2 };
+
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    std::uint64_t entry_count;
+    std::uint64_t block_count;
+    sha256_digest index_digest;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(bloom_sidecar_header) % sizeof(bloom_block) == 0 && std::is_trivially_copyable_v<bloom_sidecar_header>);
+
+/**
+ * @class bloom_filter_record
+ * @brief Directory entry: range of blocks and number of keys of one filter.
+ */
+class bloom_filter_record
+{
+public:
+    std::uint64_t first_block;
+    std::uint32_t block_count;
+    std::uint32_t key_count;
+};
+
+/**
+ * @brief Size of the directory, padded so that the blocks stay aligned.
+ */
+constexpr std::uint64_t bloom_directory_size(std::uint64_t entry_count) noexcept
+{
+    const std::uint64_t size = entry_count * sizeof(bloom_filter_record);
+    return (size + sizeof(bloom_block) - 1) / sizeof(bloom_block) * sizeof(bloom_block);
+}
+
+/**
+ * @brief Write the filters of an index, in index order.
+ * @param index Fingerprint of the index lines the filters belong to.
+ * @throws std::exception on I/O failures or oversized filters, or if the
+ *         index does not have one line per filter.
+ */
+void write_bloom_sidecar(
+    const std::filesystem::path& target,
+    std::span<const blocked_bloom_filter> filters,
+    index_fingerprint& index)
+{
+    if (index.entries() != filters.size())
+    {
+        throw std::logic_error("The Bloom filters do not match the index lines");
+    }
+
+    std::vector<bloom_filter_record> directory;
+    directory.reserve(filters.size());
+
+    std::uint64_t block_count{ 0 };
+    for (const blocked_bloom_filter& filter : filters)
+    {
+        directory.push_back(bloom_filter_record{
+            .first_block = block_count,
+            .block_count = static_cast<std::uint32_t>(filter.contents().size()),
+            .key_count = filter.key_count() });
+        block_count += filter.contents().size();
+    }
+
+    const bloom_sidecar_header header{
+        .magic = bloom_sidecar_header::expected_magic,
+        .version = bloom_sidecar_header::current_version,
+        .entry_count = filters.size(),
+        .block_count = block_count,
+        .index_digest = index.finish(),
+        .reserved = 0 };
+
+    std::ofstream output{ target, std::ios::binary | std::ios::trunc };
+    auto write = [&output](const void* data, size_t size)
+        {
+            output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+
+    write(&header, sizeof(header));
+    write(directory.data(), directory.size() * sizeof(bloom_filter_record));
+
+    static constexpr std::array<char, sizeof(bloom_block)> padding{};
+    write(padding.data(), bloom_directory_size(directory.size()) - directory.size() * sizeof(bloom_filter_record));
+
+    for (const blocked_bloom_filter& filter : filters)
+    {
+        write(filter.contents().data(), filter.contents().size_bytes());
+    }
+
+    if (!output.flush())
+    {
+        throw std::runtime_error("Failed to write the Bloom filter sidecar");
+    }
+}
+
+/**
+ * @class bloom_sidecar
+ * @brief Read-only, memory-mapped sidecar.
+ */
+class bloom_sidecar
+{
+private:
+    mapped_file file;
+    sha256_digest index_digest;
+    std::span<const bloom_filter_record> directory;
+    std::span<const bloom_block> blocks;
+
+    [[noreturn]] static void corrupted()
+    {
+        throw std::runtime_error("Bloom filter sidecar is corrupted");
+    }
+
+public:
+    /**
+     * @brief Map a sidecar and validate its header and size in O(1).
+     * @throws std::runtime_error if the file is not a valid sidecar.
+     */
+    explicit bloom_sidecar(const std::filesystem::path& path)
+        : file{ path },
+        index_digest{}
+    {
+        std::span<const std::byte> content = file.contents();
+        if (content.size() < sizeof(bloom_sidecar_header))
+        {
+            corrupted();
+        }
+
+        bloom_sidecar_header header;
+        std::memcpy(&header, content.data(), sizeof(header));
+
+        static constexpr std::uint64_t max_count = std::numeric_limits<std::uint32_t>::max();
+        if (header.magic != bloom_sidecar_header::expected_magic
+            || header.version != bloom_sidecar_header::current_version
+            || header.entry_count > max_count
+            || header.block_count > std::numeric_limits<std::uint64_t>::max() / sizeof(bloom_block) - max_count
+            || sizeof(header) + bloom_directory_size(header.entry_count) + header.block_count * sizeof(bloom_block) != content.size())
+        {
+            corrupted();
+        }
+
+        index_digest = header.index_digest;
+
+        const std::byte* position = content.data() + sizeof(header);
+        directory = std::span{ reinterpret_cast<const bloom_filter_record*>(position), static_cast<size_t>(header.entry_count) };
+        position += bloom_directory_size(header.entry_count);
+        blocks = std::span{ reinterpret_cast<const bloom_block*>(position), static_cast<size_t>(header.block_count) };
+    }
+
+    size_t size() const noexcept
+    {
+        return directory.size();
+    }
+
+    /**
+     * @brief Whether the sidecar was written for this index: same number of
+     *        lines and same text. Reads the stream to its end.
+     */
+    bool describes(std::istream& index) const
+    {
+        index_fingerprint fingerprint;
+        std::string text;
+        while (std::getline(index, text))
+        {
+            fingerprint.add(text);
+        }
+
+        return fingerprint.entries() == directory.size() && fingerprint.finish() == index_digest;
+    }
+
+    /**
+     * @brief Blocks of the filter of the `index`-th index line.
+     */
+    std::span<const bloom_block> filter(size_t index) const
+    {
+        const bloom_filter_record& record = directory[index];
+        if (record.first_block > blocks.size() || record.block_count > blocks.size() - record.first_block)
+        {
+            corrupted();
+        }
+
+        return blocks.subspan(static_cast<size_t>(record.first_block), record.block_count);
+    }
+};
+
+/**
+ * @class index_match
+ * @brief An occurrence of a queried hardware ID found in an index entry.
+ */
+class index_match
+{
+public:
+    std::string_view hardware_id;
+    hardware_id_occurrence occurrence;
+};
+
+/**
+ * @class bloom_match_statistics
+ * @brief Outcome of `match_corpus_index`: how many entries the filters let
+ *        through and how many of them actually matched.
+ */
+class bloom_match_statistics
+{
+public:
+    size_t entries;
+    size_t candidates;
+    size_t matched;
+    std::chrono::nanoseconds probe_time;
+    std::chrono::nanoseconds decode_time;
+
+    /**
+     * @brief Share of non-matching entries that the filters did not reject.
+     */
+    double false_positive_rate() const noexcept
+    {
+        const size_t negatives = entries - matched;
+        return negatives == 0 ? 0.0 : static_cast<double>(candidates - matched) / static_cast<double>(negatives);
+    }
+};
+
+/**
+ * @brief Find the entries of a `--batch` index that contain any of the
+ *        given hardware IDs.
+ *
+ * Every filter is probed first; then the index is streamed and only the
+ * lines of candidate entries are decoded. Lines beyond the end of the
+ * sidecar are always candidates.
+ *
+ * @param index `--batch` index the sidecar was written for; see
+ *        `bloom_sidecar::describes`.
+ * @param filters Its Bloom filter sidecar.
+ * @param hardware_ids IDs to look for, compared case-insensitively.
+ * @param sink Callable receiving each `index_match`.
+ * @throws nlohmann::json::exception on malformed candidate lines.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, const index_match&>
+bloom_match_statistics match_corpus_index(
+    std::istream& index,
+    const bloom_sidecar& filters,
+    std::span<const std::string> hardware_ids,
+    F&& sink)
+{
+    using clock = std::chrono::steady_clock;
+
+    std::unordered_map<std::string, std::string_view> queries;
+    std::vector<bloom_probe> probes;
+    for (const std::string& hardware_id : hardware_ids)
+    {
+        if (auto [query, inserted] = queries.try_emplace(fold_key(hardware_id), hardware_id)
+            ; inserted)
+        {
+            probes.push_back(make_bloom_probe(bloom_hash(query->first)));
+        }
+    }
+
+    bloom_match_statistics statistics{
+        .entries = 0,
+        .candidates = 0,
+        .matched = 0,
+        .probe_time = {},
+        .decode_time = {} };
+
+    const auto probe_start = clock::now();
+    std::vector<bool> candidates(filters.size(), false);
+    for (size_t i = 0; i < filters.size(); ++i)
+    {
+        const std::span<const bloom_block> filter = filters.filter(i);
+        candidates[i] = std::ranges::any_of(probes, [filter](const bloom_probe& probe) { return bloom_may_contain(filter, probe); });
+    }
+
+    statistics.probe_time = clock::now() - probe_start;
+
+    const auto decode_start = clock::now();
+    std::string text;
+    while (std::getline(index, text))
+    {
+        if (is_blank_index_line(text))
+        {
+            continue;
+        }
+
+        const size_t ordinal = statistics.entries++;
+        if (ordinal < candidates.size() && !candidates[ordinal])
+        {
+            continue;
+        }
+
+        ++statistics.candidates;
+
+        const corpus_entry entry = parse_corpus_index_line(text);
+        if (!entry.manufacturers.has_value())
+        {
+            continue;
+        }
+
+        bool matched{ false };
+        for (const manufacturer& maker : *entry.manufacturers)
+        {
+            for (const model& device : maker.devices)
+            {
+                for (const std::string& hardware_id : device.hardware_ids)
+                {
+                    if (auto query = queries.find(fold_key(hardware_id))
+                        ; query != queries.end())
+                    {
+                        matched = true;
+
+                        const index_match match{
+                            .hardware_id = query->second,
+                            .occurrence = hardware_id_occurrence{
+                                .inf = entry.path,
+                                .manufacturer = maker.name,
+                                .device = &device } };
+                        sink(match);
+                    }
+                }
+            }
+        }
+
+        statistics.matched += matched ? 1 : 0;
+    }
+
+    statistics.decode_time = clock::now() - decode_start;
+    return statistics;
+}
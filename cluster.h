@@ -0,0 +1,366 @@
+/**
+ * @file cluster.h
+ * @brief Near-duplicate package clustering: MinHash signatures over the
+ *        folded hardware-ID set of every INF, LSH banding for candidate
+ *        pairs and union-find for the clusters.
+ *
+ * A signature keeps, for each of 128 hash functions, the minimum hash over
+ * the INF's IDs; the fraction of equal slots estimates the Jaccard
+ * similarity of two ID sets. Signatures are split into 32 bands of 4 slots
+ * and INFs sharing a band land in the same bucket, so pairs become
+ * candidates without comparing every pair. A pair of Jaccard similarity s
+ * becomes a candidate with probability 1 - (1 - s^4)^32: above 99.9% at 0.7,
+ * about 87% at 0.5 and 23% at 0.3. The curve crosses 50% near 0.38, well
+ * below the 0.7 threshold the clusters are reported at, so the price of the
+ * recall is extra candidates. A candidate is only merged after its
+ * estimated similarity is checked against the threshold, against every
+ * cluster already met in its bucket rather than only the bucket's first
+ * member.
+ *
+ * Index lines are signed one at a time and directory INFs as they are
+ * parsed; reports are dropped as soon as their signature is computed and
+ * bands are bucketed one at a time, so memory stays at about 512 bytes per
+ * INF.
+ */
+
+constexpr size_t minhash_slots{ 128 };
+constexpr size_t lsh_bands{ 32 };
+constexpr size_t lsh_rows{ minhash_slots / lsh_bands };
+
+static_assert(minhash_slots % lsh_bands == 0);
+
+/**
+ * @typedef minhash_signature
+ * @brief One 32-bit minimum per hash function.
+ */
+using minhash_signature = std::array<std::uint32_t, minhash_slots>;
+
+/**
+ * @class minhash_permutation
+ * @brief Hash function `(a * x + b) >> 32` over the 64-bit ID hash.
+ */
+class minhash_permutation
+{
+public:
+    std::uint64_t multiplier;
+    std::uint64_t increment;
+};
+
+/**
+ * @brief Fixed, SplitMix64-generated hash functions, so that signatures are
+ *        reproducible across runs.
+ */
+constexpr std::array<minhash_permutation, minhash_slots> make_minhash_permutations() noexcept
+{
+    std::uint64_t state{ 0x6A09E667F3BCC908ull };
+    auto next = [&state]
+        {
+            std::uint64_t value = state += 0x9E3779B97F4A7C15ull;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        };
+
+    std::array<minhash_permutation, minhash_slots> result{};
+    for (minhash_permutation& permutation : result)
+    {
+        permutation.multiplier = next() | 1;
+        permutation.increment = next();
+    }
+
+    return result;
+}
+
+constexpr std::array<minhash_permutation, minhash_slots> minhash_permutations = make_minhash_permutations();
+
+/**
+ * @brief Compute the signature of the hardware and compatible IDs of a
+ *        report.
+ * @return The signature, or `std::nullopt` when the report lists no ID.
+ */
+std::optional<minhash_signature> compute_minhash(const report& manufacturers)
+{
+    minhash_signature result;
+    result.fill(std::numeric_limits<std::uint32_t>::max());
+
+    bool empty{ true };
+    for (const manufacturer& maker : manufacturers)
+    {
+        for (const model& device : maker.devices)
+        {
+            for (const std::string& hardware_id : device.hardware_ids)
+            {
+                const std::uint64_t hash = bloom_hash(fold_key(hardware_id));
+                for (size_t slot = 0; slot < minhash_slots; ++slot)
+                {
+                    const auto value = static_cast<std::uint32_t>(
+                        (minhash_permutations[slot].multiplier * hash + minhash_permutations[slot].increment) >> 32);
+                    result[slot] = std::min(result[slot], value);
+                }
+
+                empty = false;
+            }
+        }
+    }
+
+    return empty ? std::nullopt : std::optional{ result };
+}
+
+/**
+ * @brief Estimated Jaccard similarity of the ID sets behind two signatures.
+ */
+double estimate_jaccard(const minhash_signature& left, const minhash_signature& right) noexcept
+{
+    size_t equal{ 0 };
+    for (size_t slot = 0; slot < minhash_slots; ++slot)
+    {
+        equal += left[slot] == right[slot] ? 1 : 0;
+    }
+
+    return static_cast<double>(equal) / minhash_slots;
+}
+
+/**
+ * @brief Parse every pending entry and replace its report by its signature.
+ *
+ * `manufacturers` is released right after signing, so a whole directory
+ * never has to be held in memory.
+ *
+ * @return One signature per entry; empty for failed entries and INFs with
+ *         no ID.
+ */
+std::vector<std::optional<minhash_signature>> sign_corpus(corpus& entries, task_pool& pool)
+{
+    std::vector<std::optional<minhash_signature>> result(entries.size());
+
+    parse_each_entry(pool, entries, [&entries, &result](corpus_entry& entry)
+        {
+            if (entry.manufacturers.has_value())
+            {
+                result[static_cast<size_t>(&entry - entries.data())] = compute_minhash(*entry.manufacturers);
+                entry.manufacturers.reset();
+            }
+        });
+
+    return result;
+}
+
+/**
+ * @brief Read a `--batch` index one line at a time and keep each entry's
+ *        signature instead of its report.
+ *
+ * Only one report is decoded at any time, so an index never has to be held
+ * in memory; `entries` keeps the paths, digests and errors.
+ *
+ * @return One signature per entry, as for `sign_corpus`.
+ * @throws nlohmann::json::exception on malformed lines.
+ */
+std::vector<std::optional<minhash_signature>> sign_corpus_index(std::istream& input, corpus& entries)
+{
+    std::vector<std::optional<minhash_signature>> result;
+    std::string text;
+    while (std::getline(input, text))
+    {
+        if (is_blank_index_line(text))
+        {
+            continue;
+        }
+
+        corpus_entry& entry = entries.emplace_back(parse_corpus_index_line(text));
+        result.push_back(entry.manufacturers.has_value() ? compute_minhash(*entry.manufacturers) : std::nullopt);
+        entry.manufacturers.reset();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Load and sign a corpus from a directory or an index file, without
+ *        keeping any report.
+ * @param entries Receives the corpus, with no reports.
+ * @return One signature per entry, as for `sign_corpus`.
+ * @throws std::runtime_error if an index file cannot be opened.
+ */
+std::vector<std::optional<minhash_signature>> sign_corpus(
+    const std::filesystem::path& source,
+    corpus& entries,
+    task_pool& pool)
+{
+    if (std::filesystem::is_directory(source))
+    {
+        entries = scan_corpus(source, pool);
+        return sign_corpus(entries, pool);
+    }
+
+    std::ifstream input{ source, std::ios::binary };
+    if (!input)
+    {
+        throw std::runtime_error("Failed to open the corpus index");
+    }
+
+    entries.clear();
+    return sign_corpus_index(input, entries);
+}
+
+/**
+ * @class disjoint_sets
+ * @brief Union-find with union by size and path halving.
+ */
+class disjoint_sets
+{
+private:
+    std::vector<std::uint32_t> parent;
+    std::vector<std::uint32_t> sizes;
+
+public:
+    explicit disjoint_sets(size_t count)
+        : parent(count),
+        sizes(count, 1)
+    {
+        std::iota(parent.begin(), parent.end(), std::uint32_t{ 0 });
+    }
+
+    std::uint32_t find(std::uint32_t item) noexcept
+    {
+        while (parent[item] != item)
+        {
+            parent[item] = parent[parent[item]];
+            item = parent[item];
+        }
+
+        return item;
+    }
+
+    void unite(std::uint32_t left, std::uint32_t right) noexcept
+    {
+        left = find(left);
+        right = find(right);
+        if (left == right)
+        {
+            return;
+        }
+
+        if (sizes[left] < sizes[right])
+        {
+            std::swap(left, right);
+        }
+
+        parent[right] = left;
+        sizes[left] += sizes[right];
+    }
+};
+
+/**
+ * @class cluster_member
+ * @brief An INF of a cluster and its estimated Jaccard similarity to the
+ *        cluster's first INF.
+ */
+class cluster_member
+{
+public:
+    const corpus_entry* entry;
+    double jaccard;
+};
+
+/**
+ * @typedef package_cluster
+ * @brief Members in corpus order; the first one is the reference.
+ */
+using package_cluster = std::vector<cluster_member>;
+
+/**
+ * @brief Group the signed entries of a corpus into near-duplicate clusters.
+ * @param threshold Minimum estimated Jaccard similarity of a merged pair.
+ * @return Clusters of at least two INFs, ordered by their first member.
+ */
+std::vector<package_cluster> cluster_corpus(
+    const corpus& entries,
+    std::span<const std::optional<minhash_signature>> signatures,
+    double threshold)
+{
+    disjoint_sets sets{ entries.size() };
+
+    // one band at a time: (band hash, entry), sorted into buckets; each
+    // member is checked against one member of every cluster met so far in
+    // its bucket, which is one check per member when the bucket holds a
+    // single cluster
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> buckets;
+    std::vector<std::uint32_t> references;
+    buckets.reserve(entries.size());
+    for (size_t band = 0; band < lsh_bands; ++band)
+    {
+        buckets.clear();
+        for (size_t entry = 0; entry < signatures.size(); ++entry)
+        {
+            if (!signatures[entry].has_value())
+            {
+                continue;
+            }
+
+            std::uint64_t hash{ band };
+            for (size_t row = 0; row < lsh_rows; ++row)
+            {
+                hash = combine_hash(hash, (*signatures[entry])[band * lsh_rows + row]);
+            }
+
+            buckets.emplace_back(hash, static_cast<std::uint32_t>(entry));
+        }
+
+        std::ranges::sort(buckets);
+        for (size_t first = 0; first < buckets.size();)
+        {
+            references.assign(1, buckets[first].second);
+            size_t last = first + 1;
+            for (; last < buckets.size() && buckets[last].first == buckets[first].first; ++last)
+            {
+                const std::uint32_t candidate = buckets[last].second;
+                bool merged{ false };
+                for (const std::uint32_t reference : references)
+                {
+                    if (sets.find(reference) == sets.find(candidate))
+                    {
+                        merged = true;
+                    }
+                    else if (estimate_jaccard(*signatures[reference], *signatures[candidate]) >= threshold)
+                    {
+                        sets.unite(reference, candidate);
+                        merged = true;
+                    }
+                }
+
+                if (!merged)
+                {
+                    references.push_back(candidate);
+                }
+            }
+
+            first = last;
+        }
+    }
+
+    std::vector<package_cluster> result;
+    std::unordered_map<std::uint32_t, size_t> cluster_of;
+    std::vector<std::uint32_t> reference_of;
+    for (size_t entry = 0; entry < signatures.size(); ++entry)
+    {
+        if (!signatures[entry].has_value())
+        {
+            continue;
+        }
+
+        const std::uint32_t root = sets.find(static_cast<std::uint32_t>(entry));
+        auto [position, inserted] = cluster_of.try_emplace(root, result.size());
+        if (inserted)
+        {
+            result.emplace_back();
+            reference_of.push_back(static_cast<std::uint32_t>(entry));
+        }
+
+        result[position->second].push_back(cluster_member{
+            .entry = &entries[entry],
+            .jaccard = estimate_jaccard(*signatures[reference_of[position->second]], *signatures[entry]) });
+    }
+
+    std::erase_if(result, [](const package_cluster& cluster) { return cluster.size() < 2; });
+    return result;
+}
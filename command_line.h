@@ -0,0 +1,297 @@
+/**
+ * @file command_line.h
+ * @brief Command-line parsing: one mode switch plus positional inputs.
+ */
+
+/**
+ * @enum command
+ * @brief Operating mode selected on the command line.
+ */
+enum class command
+{
+    report,
+    batch,
+    diff,
+    watch,
+    query,
+    match,
+    rank,
+    inventory,
+    plan,
+    cluster,
+    dedup,
+    triage
+};
+
+/**
+ * @class options
+ * @brief Parsed command line.
+ */
+class options
+{
+public:
+    command mode{ command::report };
+    std::vector<std::filesystem::path> inputs;
+    bool manifest{ false };
+    bool lenient{ false };
+    std::optional<std::filesystem::path> cache_directory;
+    std::string pattern;
+    std::vector<std::string> hardware_ids;
+    std::vector<std::string> compatible_ids;
+    std::optional<platform_decoration> platform;
+    std::optional<std::filesystem::path> bloom_sidecar;
+    std::filesystem::path inventory;
+    std::optional<size_t> reader_threads;
+    std::optional<size_t> parser_threads;
+    std::optional<size_t> read_ahead;
+    std::optional<std::chrono::seconds> file_timeout;
+    std::optional<std::chrono::seconds> deadline;
+    parse_limits limits;
+};
+
+constexpr std::string_view usage =
+    "Usage:\n"
+    "  inf_to_json [--manifest] [--lenient] [--cache <snapshot-directory>] [<limits>] <inf-file-path>\n"
+    "  inf_to_json --batch [--lenient] [--cache <snapshot-directory>] [--bloom <sidecar>]\n"
+    "              [--readers <count>] [--parsers <count>] [--read-ahead <count>]\n"
+    "              [--file-timeout <seconds>] [--deadline <seconds>] [<limits>] <directory>\n"
+    "  inf_to_json --diff <old-directory-or-index> <new-directory-or-index>\n"
+    "  inf_to_json --watch <inf-file-path>\n"
+    "  inf_to_json --query <hardware-id-pattern> <directory-or-index>\n"
+    "  inf_to_json --match <hardware-id> [--match <hardware-id>...] [--bloom <sidecar>] <index>\n"
+    "  inf_to_json --rank <hardware-id> [--rank <hardware-id>...] [--compatible <compatible-id>...]\n"
+    "              [--platform <decoration>] <directory-or-index>\n"
+    "  inf_to_json --inventory <inventory.jsonl> <directory-or-index>\n"
+    "  inf_to_json --plan <inventory.jsonl> <directory-or-index>\n"
+    "  inf_to_json --cluster <directory-or-index>\n"
+    "  inf_to_json --dedup <directory-or-index>\n"
+    "  inf_to_json --triage [<limits>] <directory>\n"
+    "Limits: [--max-file-size <bytes>] [--max-line-length <characters>] [--max-fields <count>]\n"
+    "        [--max-substitutions <count>]\n";
+
+/**
+ * @brief Parse a positive decimal count.
+ */
+std::optional<size_t> parse_count(std::wstring_view text)
+{
+    const std::string digits = to_utf8(text);
+
+    size_t value{ 0 };
+    auto [last, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (error != std::errc{} || last != digits.data() + digits.size() || value == 0)
+    {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Parse `argv` into `options`.
+ * @return Parsed options, or `std::nullopt` if the arguments are invalid.
+ */
+std::optional<options> parse_command_line(int argc, wchar_t* argv[])
+{
+    static constexpr std::pair<std::wstring_view, command> modes[]{
+        { L"--batch", command::batch },
+        { L"--diff", command::diff },
+        { L"--watch", command::watch },
+        { L"--cluster", command::cluster },
+        { L"--dedup", command::dedup },
+        { L"--triage", command::triage }
+    };
+
+    options result;
+    std::optional<command> selected;
+    bool limited{ false };
+    for (int i = 1; i < argc; ++i)
+    {
+        std::wstring_view argument{ argv[i] };
+
+        if (argument == L"--manifest")
+        {
+            result.manifest = true;
+            continue;
+        }
+
+        if (argument == L"--lenient")
+        {
+            result.lenient = true;
+            continue;
+        }
+
+        if (argument == L"--cache")
+        {
+            if (++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            result.cache_directory = std::filesystem::path{ argv[i] };
+            continue;
+        }
+
+        if (argument == L"--bloom")
+        {
+            if (++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            result.bloom_sidecar = std::filesystem::path{ argv[i] };
+            continue;
+        }
+
+        if (argument == L"--readers" || argument == L"--parsers" || argument == L"--read-ahead")
+        {
+            std::optional<size_t> count = ++i == argc ? std::nullopt : parse_count(argv[i]);
+            if (!count.has_value())
+            {
+                return std::nullopt;
+            }
+
+            (argument == L"--readers" ? result.reader_threads
+                : argument == L"--parsers" ? result.parser_threads
+                : result.read_ahead) = count;
+            continue;
+        }
+
+        if (argument == L"--file-timeout" || argument == L"--deadline")
+        {
+            std::optional<size_t> seconds = ++i == argc ? std::nullopt : parse_count(argv[i]);
+            if (!seconds.has_value())
+            {
+                return std::nullopt;
+            }
+
+            (argument == L"--file-timeout" ? result.file_timeout : result.deadline) = std::chrono::seconds{ *seconds };
+            continue;
+        }
+
+        if (argument == L"--max-file-size" || argument == L"--max-line-length"
+            || argument == L"--max-fields" || argument == L"--max-substitutions")
+        {
+            std::optional<size_t> value = ++i == argc ? std::nullopt : parse_count(argv[i]);
+            if (!value.has_value())
+            {
+                return std::nullopt;
+            }
+
+            if (argument == L"--max-file-size")
+            {
+                result.limits.max_file_size = *value;
+            }
+            else
+            {
+                (argument == L"--max-line-length" ? result.limits.max_line_length
+                    : argument == L"--max-fields" ? result.limits.max_fields
+                    : result.limits.max_substitutions) = *value;
+            }
+
+            limited = true;
+            continue;
+        }
+
+        if (argument == L"--match" || argument == L"--rank")
+        {
+            const command mode = argument == L"--match" ? command::match : command::rank;
+            if ((selected.has_value() && *selected != mode) || ++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            selected = mode;
+            result.hardware_ids.push_back(to_utf8(std::wstring_view{ argv[i] }));
+            continue;
+        }
+
+        if (argument == L"--compatible")
+        {
+            if (++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            result.compatible_ids.push_back(to_utf8(std::wstring_view{ argv[i] }));
+            continue;
+        }
+
+        if (argument == L"--platform")
+        {
+            if (result.platform.has_value() || ++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            result.platform = parse_platform_decoration(to_utf8(std::wstring_view{ argv[i] }));
+            if (!result.platform.has_value() || result.platform->architecture.empty())
+            {
+                return std::nullopt;
+            }
+
+            continue;
+        }
+
+        if (argument == L"--query")
+        {
+            if (selected.has_value() || ++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            selected = command::query;
+            result.pattern = to_utf8(std::wstring_view{ argv[i] });
+            continue;
+        }
+
+        if (argument == L"--inventory" || argument == L"--plan")
+        {
+            if (selected.has_value() || ++i == argc)
+            {
+                return std::nullopt;
+            }
+
+            selected = argument == L"--inventory" ? command::inventory : command::plan;
+            result.inventory = std::filesystem::path{ argv[i] };
+            continue;
+        }
+
+        if (auto mode = std::ranges::find(modes, argument, &std::pair<std::wstring_view, command>::first)
+            ; mode != std::ranges::end(modes))
+        {
+            if (selected.has_value())
+            {
+                return std::nullopt;
+            }
+
+            selected = mode->second;
+            continue;
+        }
+
+        if (argument.starts_with(L"--"))
+        {
+            return std::nullopt;
+        }
+
+        result.inputs.emplace_back(argument);
+    }
+
+    result.mode = selected.value_or(command::report);
+
+    const size_t expected_inputs = result.mode == command::diff ? 2 : 1;
+    if (result.inputs.size() != expected_inputs
+        || (result.manifest && result.mode != command::report)
+        || (result.lenient && result.mode != command::report && result.mode != command::batch)
+        || (limited && result.mode != command::report && result.mode != command::batch && result.mode != command::triage)
+        || (result.cache_directory.has_value() && result.mode != command::report && result.mode != command::batch)
+        || (result.bloom_sidecar.has_value() && result.mode != command::batch && result.mode != command::match)
+        || ((!result.compatible_ids.empty() || result.platform.has_value()) && result.mode != command::rank)
+        || ((result.reader_threads.has_value() || result.parser_threads.has_value() || result.read_ahead.has_value()
+            || result.file_timeout.has_value() || result.deadline.has_value())
+            && result.mode != command::batch))
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
@@ -0,0 +1,685 @@
+/**
+ * @file corpus.h
+ * @brief Multi-INF corpora: directory scans, per-INF content hashes and the
+ *        JSON Lines index written by batch mode.
+ *
+ * A corpus is either a directory tree (every `*.inf` below it) or an index
+ * file previously produced by `--batch`, one JSON object per INF:
+ *
+ * ```json
+ * {"path":"oem1\\oem1.inf","sha256":"…","manufacturers":[…],"version":{…}}
+ * {"path":"errata.inf","sha256":"…","error":"…"}
+ * ```
+ *
+ * Lenient parses add `"diagnostics":[{"section":…,"line":…,"reason":…}]`
+ * for the lines they skipped.
+ */
+
+/**
+ * @class corpus_entry
+ * @brief One INF of a corpus.
+ *
+ * `location` is the file to parse and is empty for entries read from an
+ * index. `manufacturers` and `version` stay empty until the INF is parsed
+ * (or when it failed to parse, in which case `error` holds the reason).
+ * `cancelled` is set when the failure is a cancelled parse
+ * (`operation_cancelled`) rather than an INF error. `diagnostics` lists the
+ * lines a lenient parse skipped.
+ */
+class corpus_entry
+{
+public:
+    std::filesystem::path location;
+    std::string path;
+    std::string sha256;
+    std::optional<report> manufacturers;
+    std::optional<package_version> version;
+    std::string error;
+    bool cancelled{ false };
+    std::vector<parse_diagnostic> diagnostics;
+};
+
+/**
+ * @typedef corpus
+ * @brief Entries in directory-walk order (sorted by path).
+ */
+using corpus = std::vector<corpus_entry>;
+
+/**
+ * @brief Fold a UTF-8 identifier for ordinal comparison.
+ *
+ * ASCII text (nearly every hardware ID and path) is folded in place, which
+ * matches `CharLowerW` for that range; anything else round-trips through
+ * UTF-16 and `fold_case`.
+ */
+std::string fold_key(std::string_view utf8)
+{
+    if (std::ranges::all_of(utf8, [](char c) { return static_cast<unsigned char>(c) < 0x80; }))
+    {
+        std::string result{ utf8 };
+        for (char& c : result)
+        {
+            if (c >= 'A' && c <= 'Z')
+            {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+
+        return result;
+    }
+
+    return to_utf8(fold_case(std::wstring_view{ from_utf8(utf8) }));
+}
+
+/**
+ * @class inf_listing
+ * @brief A corpus file and its size, as reported by the directory walk.
+ */
+class inf_listing
+{
+public:
+    std::filesystem::path path;
+    std::uint64_t size;
+};
+
+/**
+ * @brief List every `*.inf` file below a directory with its size, sorted by
+ *        path so that the walk order is reproducible.
+ */
+std::vector<inf_listing> list_inf_files(const std::filesystem::path& root)
+{
+    std::vector<inf_listing> result;
+    for (const auto& item : std::filesystem::recursive_directory_iterator(
+        root,
+        std::filesystem::directory_options::skip_permission_denied))
+    {
+        const std::filesystem::path extension = item.path().extension();
+        if (item.is_regular_file()
+            && key_name_view{ extension.native().data(), extension.native().size() } == L".inf")
+        {
+            // the walk already fetched the size; a failure only costs the
+            // scheduling hint
+            std::error_code error;
+            const std::uint64_t size = item.file_size(error);
+            result.push_back(inf_listing{ .path = item.path(), .size = error ? 0 : size });
+        }
+    }
+
+    std::ranges::sort(result, std::less{}, &inf_listing::path);
+    return result;
+}
+
+/**
+ * @brief List every `*.inf` file below a directory, sorted by path so that
+ *        the walk order is reproducible.
+ */
+std::vector<std::filesystem::path> find_inf_files(const std::filesystem::path& root)
+{
+    std::vector<std::filesystem::path> result;
+    for (inf_listing& file : list_inf_files(root))
+    {
+        result.push_back(std::move(file.path));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Create an unparsed entry for a file of a directory corpus.
+ */
+corpus_entry make_corpus_entry(const std::filesystem::path& root, const std::filesystem::path& file)
+{
+    return corpus_entry{
+        .location = file,
+        .path = to_utf8(file.lexically_relative(root).native()),
+        .sha256 = {},
+        .manufacturers = std::nullopt,
+        .version = std::nullopt,
+        .error = {},
+        .cancelled = false,
+        .diagnostics = {} };
+}
+
+/**
+ * @brief Run an operation on an entry and record any failure in the entry
+ *        instead of throwing: corpora routinely contain INFs that are not
+ *        driver INFs at all.
+ */
+template <typename F>
+requires std::is_invocable_v<F&>
+void record_failure(corpus_entry& entry, F operation) noexcept
+{
+    try
+    {
+        operation();
+    }
+    catch (const operation_cancelled& e)
+    {
+        entry.error = e.what();
+        entry.cancelled = true;
+    }
+    catch (const std::exception& e)
+    {
+        entry.error = e.what();
+    }
+    catch (...)
+    {
+        entry.error = "Unexpected error";
+    }
+}
+
+/**
+ * @brief Check INF content that was already read against the parse limits,
+ *        as by an `io_ring_reader`, then hash it.
+ * @return The digest, or `std::nullopt` if the INF is over a limit or
+ *         hashing failed and the failure was recorded in the entry.
+ */
+std::optional<sha256_digest> hash_corpus_entry(
+    corpus_entry& entry,
+    std::span<const std::byte> contents,
+    const parse_limits& limits = {}) noexcept
+{
+    std::optional<sha256_digest> digest;
+    record_failure(entry, [&]
+        {
+            check_parse_limits(contents, limits);
+            digest = sha256(contents);
+            entry.sha256 = to_hex(*digest);
+        });
+
+    return digest;
+}
+
+/**
+ * @brief Check the INF content of an entry (not the payload it references)
+ *        against the parse limits and hash it. A rejected INF is not hashed.
+ * @return The digest, or `std::nullopt` if the INF is over a limit or
+ *         hashing failed and the failure was recorded in the entry.
+ */
+std::optional<sha256_digest> hash_corpus_entry(corpus_entry& entry, const parse_limits& limits = {}) noexcept
+{
+    std::optional<sha256_digest> digest;
+    record_failure(entry, [&]
+        {
+            mapped_file file{ entry.location };
+            digest = hash_corpus_entry(entry, file.contents(), limits);
+        });
+
+    return digest;
+}
+
+/**
+ * @enum parse_mode
+ * @brief Whether a malformed line fails the whole INF (`strict`) or is
+ *        recorded as a diagnostic and skipped (`lenient`).
+ */
+enum class parse_mode
+{
+    strict,
+    lenient
+};
+
+/**
+ * @brief Build the report and version of an entry from an open INF source.
+ *
+ * Lenient parses go through the `try_*` builders and throw for nothing but
+ * cancellation and failures to open the source; an INF whose
+ * `[Manufacturer]` section cannot be read still ends as an error entry.
+ */
+template <typename inf_source>
+void select_entry_data(corpus_entry& entry, const inf_source& inf, parse_mode mode, std::stop_token stop)
+{
+    if (mode == parse_mode::strict)
+    {
+        entry.manufacturers = select_report_data(inf, stop);
+        entry.version = select_version_data(inf, stop);
+        return;
+    }
+
+    std::vector<line_diagnostic> diagnostics;
+    std::expected<report, inf_error> manufacturers = try_select_report_data(inf, diagnostics, stop);
+    std::expected<package_version, inf_error> version = try_select_version_data(inf, diagnostics, stop);
+    entry.diagnostics = to_parse_diagnostics(diagnostics);
+
+    if (!manufacturers.has_value())
+    {
+        entry.error = describe(manufacturers.error());
+        return;
+    }
+
+    entry.manufacturers = std::move(*manufacturers);
+    if (version.has_value())
+    {
+        entry.version = std::move(*version);
+    }
+}
+
+/**
+ * @brief Parse an entry into its report through SetupAPI.
+ * @param stop Abandons the parse within one line; the entry then records
+ *        the cancellation as its error.
+ */
+void parse_corpus_entry(corpus_entry& entry, std::stop_token stop = {}, parse_mode mode = parse_mode::strict) noexcept
+{
+    record_failure(entry, [&entry, &stop, mode]
+        {
+            select_entry_data(entry, inf_file{ entry.location }, mode, stop);
+        });
+}
+
+/**
+ * @brief Parse an entry into its report through its `.infc` snapshot,
+ *        building the snapshot first when there is none for this content.
+ */
+void parse_corpus_entry(
+    corpus_entry& entry,
+    const sha256_digest& source,
+    const std::filesystem::path& cache_directory,
+    std::stop_token stop = {},
+    parse_mode mode = parse_mode::strict) noexcept
+{
+    record_failure(entry, [&]
+        {
+            with_cached_inf(
+                entry.location,
+                source,
+                cache_directory,
+                [&](const auto& inf) { select_entry_data(entry, inf, mode, stop); },
+                stop);
+        });
+}
+
+/**
+ * @brief Hash and parse one file of a directory corpus, as batch mode does.
+ * @param cache_directory Snapshot cache; parse through SetupAPI directly
+ *        when absent.
+ */
+corpus_entry build_corpus_entry(
+    const std::filesystem::path& root,
+    const std::filesystem::path& file,
+    const std::optional<std::filesystem::path>& cache_directory)
+{
+    corpus_entry entry = make_corpus_entry(root, file);
+    if (std::optional<sha256_digest> digest = hash_corpus_entry(entry))
+    {
+        if (cache_directory.has_value())
+        {
+            parse_corpus_entry(entry, *digest, *cache_directory);
+        }
+        else
+        {
+            parse_corpus_entry(entry);
+        }
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Run an entry operation over a subset of entries on the pool and
+ *        wait for completion, rethrowing the first failure.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, corpus_entry&>
+void for_each_entry(task_pool& pool, std::span<corpus_entry* const> entries, F operation)
+{
+    std::vector<std::future<void>> pending;
+    pending.reserve(entries.size());
+    for (corpus_entry* entry : entries)
+    {
+        pending.push_back(pool.async([entry, &operation] { operation(*entry); }));
+    }
+
+    // every task references `operation`, so all of them are awaited before
+    // the first failure is rethrown
+    std::exception_ptr failure;
+    for (auto& result : pending)
+    {
+        try
+        {
+            result.get();
+        }
+        catch (...)
+        {
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+        }
+    }
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+/**
+ * @brief Test whether an entry still needs a parse: it names a file, has no
+ *        report yet and no recorded failure.
+ */
+bool is_pending(const corpus_entry& entry) noexcept
+{
+    return !entry.location.empty() && !entry.manufacturers.has_value() && entry.error.empty();
+}
+
+/**
+ * @brief Parse each pending entry of a subset on the pool, then pass every
+ *        entry of the subset to `visit` on the worker that parsed it.
+ *
+ * `visit` runs concurrently for different entries.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, corpus_entry&>
+void parse_each_entry(task_pool& pool, std::span<corpus_entry* const> entries, F visit)
+{
+    for_each_entry(pool, entries, [&visit](corpus_entry& entry)
+        {
+            if (is_pending(entry))
+            {
+                parse_corpus_entry(entry);
+            }
+
+            visit(entry);
+        });
+}
+
+/**
+ * @brief Parse each pending entry of a corpus on the pool, then pass every
+ *        entry to `visit`, as for a subset.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, corpus_entry&>
+void parse_each_entry(task_pool& pool, corpus& entries, F visit)
+{
+    std::vector<corpus_entry*> all;
+    all.reserve(entries.size());
+    for (corpus_entry& entry : entries)
+    {
+        all.push_back(&entry);
+    }
+
+    parse_each_entry(pool, all, std::move(visit));
+}
+
+/**
+ * @brief List a directory corpus and hash every INF; reports are not built.
+ *        INFs over the default `parse_limits` are recorded as failed and
+ *        will not be parsed.
+ */
+corpus scan_corpus(const std::filesystem::path& root, task_pool& pool)
+{
+    corpus result;
+    for (const auto& file : find_inf_files(root))
+    {
+        result.push_back(make_corpus_entry(root, file));
+    }
+
+    std::vector<corpus_entry*> all;
+    all.reserve(result.size());
+    for (corpus_entry& entry : result)
+    {
+        all.push_back(&entry);
+    }
+
+    for_each_entry(pool, all, [](corpus_entry& entry) { hash_corpus_entry(entry); });
+    return result;
+}
+
+/**
+ * @brief Test whether an index line is blank; blank lines are not entries.
+ */
+bool is_blank_index_line(std::string_view text) noexcept
+{
+    return text.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+/**
+ * @brief Read back a decoded hardware ID as `--batch` writes it.
+ * @throws nlohmann::json::exception on a malformed object.
+ */
+decoded_hardware_id read_decoded_hardware_id(const nlohmann::json& item)
+{
+    static constexpr std::array<std::pair<std::string_view, hardware_id_bus>, 5> buses{ {
+        { "other", hardware_id_bus::other },
+        { "pci", hardware_id_bus::pci },
+        { "usb", hardware_id_bus::usb },
+        { "acpi", hardware_id_bus::acpi },
+        { "hdaudio", hardware_id_bus::hdaudio } } };
+
+    decoded_hardware_id result;
+
+    const std::string bus = item.at("bus").get<std::string>();
+    if (auto known = std::ranges::find(buses, bus, &std::pair<std::string_view, hardware_id_bus>::first)
+        ; known != buses.end())
+    {
+        result.bus = known->second;
+    }
+
+    if (auto acpi_vendor = item.find("acpi_vendor")
+        ; acpi_vendor != item.end())
+    {
+        const std::string text = acpi_vendor->get<std::string>();
+        std::ranges::copy(std::string_view{ text }.substr(0, result.acpi_vendor.size()), result.acpi_vendor.begin());
+        result.fields |= decoded_hardware_id::has_acpi_vendor;
+    }
+
+    auto read = [&item, &result](const char* name, std::uint8_t field, auto& value)
+        {
+            if (auto found = item.find(name)
+                ; found != item.end())
+            {
+                found->get_to(value);
+                result.fields |= field;
+            }
+        };
+
+    read("vendor", decoded_hardware_id::has_vendor, result.vendor);
+    read("device", decoded_hardware_id::has_device, result.device);
+    read("subsystem", decoded_hardware_id::has_subsystem, result.subsystem);
+    read("revision", decoded_hardware_id::has_revision, result.revision);
+    read("function", decoded_hardware_id::has_function, result.function);
+    return result;
+}
+
+/**
+ * @brief Parse one non-blank line of a `--batch` index.
+ * @throws nlohmann::json::exception on a malformed line.
+ */
+corpus_entry parse_corpus_index_line(std::string_view text)
+{
+    const nlohmann::json item = nlohmann::json::parse(text);
+
+    corpus_entry entry{
+        .location = {},
+        .path = item.at("path").get<std::string>(),
+        .sha256 = item.value("sha256", std::string{}),
+        .manufacturers = std::nullopt,
+        .version = std::nullopt,
+        .error = item.value("error", std::string{}),
+        .cancelled = false,
+        .diagnostics = {} };
+
+    if (auto manufacturers = item.find("manufacturers")
+        ; manufacturers != item.end())
+    {
+        report output;
+        for (const auto& maker : *manufacturers)
+        {
+            manufacturer report_entry{ .name = maker.at("name").get<std::string>() };
+            for (const auto& device : maker.at("devices"))
+            {
+                auto hardware_ids = device.at("hardware_ids").get<std::vector<std::string>>();
+
+                // indexes written before the IDs were decoded carry only
+                // the strings
+                std::vector<decoded_hardware_id> decoded_hardware_ids;
+                if (auto decoded = device.find("decoded_hardware_ids")
+                    ; decoded != device.end() && decoded->size() == hardware_ids.size())
+                {
+                    decoded_hardware_ids.reserve(decoded->size());
+                    for (const auto& hardware_id : *decoded)
+                    {
+                        decoded_hardware_ids.push_back(read_decoded_hardware_id(hardware_id));
+                    }
+                }
+                else
+                {
+                    decoded_hardware_ids = decode_hardware_ids(hardware_ids);
+                }
+
+                report_entry.devices.push_back(model{
+                    .description = device.at("description").get<std::string>(),
+                    .hardware_ids = std::move(hardware_ids),
+                    .architectures = device.at("architectures").get<std::vector<std::string>>(),
+                    .decoded_hardware_ids = std::move(decoded_hardware_ids) });
+            }
+
+            output.push_back(std::move(report_entry));
+        }
+
+        entry.manufacturers = std::move(output);
+    }
+
+    if (auto diagnostics = item.find("diagnostics")
+        ; diagnostics != item.end())
+    {
+        for (const auto& diagnostic : *diagnostics)
+        {
+            entry.diagnostics.push_back(parse_diagnostic{
+                .section = diagnostic.at("section").get<std::string>(),
+                .line = diagnostic.at("line").get<size_t>(),
+                .reason = diagnostic.at("reason").get<std::string>() });
+        }
+    }
+
+    if (auto version = item.find("version")
+        ; version != item.end())
+    {
+        entry.version = package_version{
+            .class_name = version->value("class", std::string{}),
+            .provider = version->value("provider", std::string{}),
+            .catalog_file = version->value("catalog_file", std::string{}),
+            .driver_date = version->value("driver_date", std::string{}),
+            .driver_version = version->value("driver_version", std::string{}) };
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Read a corpus from a `--batch` index.
+ * @throws nlohmann::json::exception on malformed lines.
+ */
+corpus read_corpus_index(std::istream& input)
+{
+    corpus result;
+    std::string text;
+    while (std::getline(input, text))
+    {
+        if (!is_blank_index_line(text))
+        {
+            result.push_back(parse_corpus_index_line(text));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Load a corpus from a directory (hashed, unparsed) or an index file
+ *        (fully loaded).
+ * @throws std::runtime_error if an index file cannot be opened.
+ */
+corpus load_corpus(const std::filesystem::path& source, task_pool& pool)
+{
+    if (std::filesystem::is_directory(source))
+    {
+        return scan_corpus(source, pool);
+    }
+
+    std::ifstream input{ source, std::ios::binary };
+    if (!input)
+    {
+        throw std::runtime_error("Failed to open the corpus index");
+    }
+
+    return read_corpus_index(input);
+}
+
+/**
+ * @brief Parse every entry that has a file and has not been parsed yet.
+ */
+void parse_corpus(corpus& entries, task_pool& pool)
+{
+    std::vector<corpus_entry*> pending;
+    for (corpus_entry& entry : entries)
+    {
+        if (is_pending(entry))
+        {
+            pending.push_back(&entry);
+        }
+    }
+
+    parse_each_entry(pool, pending, [](corpus_entry&) {});
+}
+
+/**
+ * @class triage_entry
+ * @brief Triage result of one INF of a directory, or why it failed.
+ */
+class triage_entry
+{
+public:
+    std::string path;
+    std::optional<package_triage> triage;
+    std::string error;
+};
+
+/**
+ * @brief Triage every INF below a directory on the pool: check it against
+ *        the parse limits, then read its `[Version]` keys through SetupAPI.
+ *        Nothing is hashed and no models section is read.
+ * @return Entries in walk order.
+ */
+std::vector<triage_entry> triage_corpus(const std::filesystem::path& root, const parse_limits& limits, task_pool& pool)
+{
+    corpus entries;
+    for (const auto& file : find_inf_files(root))
+    {
+        entries.push_back(make_corpus_entry(root, file));
+    }
+
+    std::vector<corpus_entry*> all;
+    all.reserve(entries.size());
+    for (corpus_entry& entry : entries)
+    {
+        all.push_back(&entry);
+    }
+
+    std::vector<std::optional<package_triage>> triages(entries.size());
+    for_each_entry(pool, all, [&entries, &triages, &limits](corpus_entry& entry)
+        {
+            record_failure(entry, [&]
+                {
+                    {
+                        mapped_file content{ entry.location };
+                        check_parse_limits(content.contents(), limits);
+                    }
+
+                    triages[static_cast<size_t>(&entry - entries.data())] = select_triage_data(inf_file{ entry.location });
+                });
+        });
+
+    std::vector<triage_entry> result;
+    result.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        result.push_back(triage_entry{
+            .path = std::move(entries[i].path),
+            .triage = std::move(triages[i]),
+            .error = std::move(entries[i].error) });
+    }
+
+    return result;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file dedup.h
+ * @brief Corpus-wide model deduplication.
+ *
+ * `select_report_data` groups models within one manufacturer of one INF;
+ * across a corpus the same (description, hardware IDs) model appears in
+ * many INFs. Workers parse INFs and insert every model into a
+ * `sharded_map` keyed by the canonical `model_key`, so each unique model
+ * is kept once with the list of places it comes from.
+ */
+
+/**
+ * @class model_reference
+ * @brief One place a model appears: INF, manufacturer and the
+ *        architectures of its models sections there.
+ */
+class model_reference
+{
+public:
+    const corpus_entry* entry;
+    std::string manufacturer;
+    std::vector<std::string> architectures;
+};
+
+/**
+ * @class deduplicated_model
+ * @brief A unique model with every reference to it, in corpus order.
+ *        `description` and `hardware_ids` are spelled as in the first
+ *        reference.
+ */
+class deduplicated_model
+{
+public:
+    std::string description;
+    std::vector<std::string> hardware_ids;
+    std::vector<model_reference> references;
+};
+
+/**
+ * @brief Canonical key of a model read back from a report.
+ */
+model_key make_model_key(const model& device)
+{
+    const std::wstring description = from_utf8(device.description);
+
+    std::vector<hardware_id> hardware_ids;
+    hardware_ids.reserve(device.hardware_ids.size());
+    for (const std::string& id : device.hardware_ids)
+    {
+        hardware_ids.emplace_back(std::wstring_view{ from_utf8(id) });
+    }
+
+    return make_model_key(key_name{ description.data(), description.size() }, std::move(hardware_ids));
+}
+
+/**
+ * @brief Parse every pending entry and merge the models of the whole corpus.
+ *
+ * Reports are released once their models are merged.
+ *
+ * @return Unique models ordered by their first reference.
+ */
+std::vector<deduplicated_model> deduplicate_corpus_models(corpus& entries, task_pool& pool)
+{
+    sharded_map<model_key, deduplicated_model> models;
+
+    parse_each_entry(pool, entries, [&models](corpus_entry& entry)
+        {
+            if (!entry.manufacturers.has_value())
+            {
+                return;
+            }
+
+            for (manufacturer& maker : *entry.manufacturers)
+            {
+                for (model& device : maker.devices)
+                {
+                    models.upsert(make_model_key(device), [&](deduplicated_model& unique, bool inserted)
+                        {
+                            // keep the spelling of the earliest INF whatever
+                            // the order workers finish in
+                            if (inserted || &entry < unique.references.front().entry)
+                            {
+                                unique.description = device.description;
+                                unique.hardware_ids = device.hardware_ids;
+                            }
+
+                            unique.references.push_back(model_reference{
+                                .entry = &entry,
+                                .manufacturer = maker.name,
+                                .architectures = std::move(device.architectures) });
+
+                            if (unique.references.front().entry > &entry)
+                            {
+                                std::swap(unique.references.front(), unique.references.back());
+                            }
+                        });
+                }
+            }
+
+            entry.manufacturers.reset();
+        });
+
+    std::vector<deduplicated_model> result = models.drain();
+    for (deduplicated_model& unique : result)
+    {
+        std::ranges::sort(unique.references, [](const model_reference& left, const model_reference& right)
+            {
+                return std::tie(left.entry, left.manufacturer) < std::tie(right.entry, right.manufacturer);
+            });
+    }
+
+    std::ranges::sort(result, [](const deduplicated_model& left, const deduplicated_model& right)
+        {
+            return std::tie(left.references.front().entry, left.description)
+                < std::tie(right.references.front().entry, right.description);
+        });
+
+    return result;
+}
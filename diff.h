@@ -0,0 +1,301 @@
+/**
+ * @file diff.h
+ * @brief Differences between two corpora at hardware-ID and model level.
+ *
+ * Every (folded key, INF) pair of each side is collected into a vector,
+ * sorted, and the two vectors are merged. For each key the INFs only on the
+ * old side are the ones it left and the INFs only on the new side the ones
+ * it appeared in.
+ *
+ * INFs found at the same relative path with the same content hash on both
+ * sides contribute identical pairs to both vectors, so they are left out of
+ * the merge. Their keys are still collected once, from one side: a key is
+ * only `added` if no INF of the old corpus had it and only `removed` if no
+ * INF of the new corpus has it. Any other change of its INFs is `moved`.
+ */
+
+/**
+ * @enum change_kind
+ * @brief Kind of a difference record.
+ */
+enum class change_kind
+{
+    added,
+    removed,
+    moved
+};
+
+/**
+ * @class keyed_occurrence
+ * @brief A folded key (hardware ID or whole model) seen in one INF.
+ *
+ * Views point into the corpus the occurrence was collected from.
+ */
+class keyed_occurrence
+{
+public:
+    std::string key;
+    std::string_view inf;
+    std::string_view hardware_id;
+    const model* device;
+};
+
+/**
+ * @class diff_record
+ * @brief One streamed difference. `from` lists the INFs the key left, `to`
+ *        the INFs it appeared in.
+ *
+ * `subject` is `hardware_id` or `model`; `hardware_id` is only set for the
+ * former.
+ */
+class diff_record
+{
+public:
+    std::string_view subject;
+    change_kind change;
+    std::string_view hardware_id;
+    const model* device;
+    std::vector<std::string_view> from;
+    std::vector<std::string_view> to;
+};
+
+/**
+ * @brief Sort occurrences by (key, INF) and drop repeated pairs.
+ */
+void sort_occurrences(std::vector<keyed_occurrence>& occurrences)
+{
+    auto order = [](const keyed_occurrence& occurrence) { return std::tie(occurrence.key, occurrence.inf); };
+    std::ranges::sort(occurrences, std::less{}, order);
+
+    auto repeated = std::ranges::unique(occurrences, std::equal_to{}, order);
+    occurrences.erase(repeated.begin(), repeated.end());
+}
+
+/**
+ * @brief Collect the hardware-ID and model occurrences of one parsed entry.
+ */
+void collect_entry_occurrences(
+    const corpus_entry& entry,
+    std::vector<keyed_occurrence>& hardware_ids,
+    std::vector<keyed_occurrence>& models)
+{
+    static constexpr char separator = '\0';
+
+    if (!entry.manufacturers.has_value())
+    {
+        return;
+    }
+
+    for (const manufacturer& maker : *entry.manufacturers)
+    {
+        for (const model& device : maker.devices)
+        {
+            std::string model_key = fold_key(device.description);
+            for (const std::string& hardware_id : device.hardware_ids)
+            {
+                std::string folded = fold_key(hardware_id);
+
+                model_key += separator;
+                model_key += folded;
+
+                hardware_ids.push_back(keyed_occurrence{
+                    .key = std::move(folded),
+                    .inf = entry.path,
+                    .hardware_id = hardware_id,
+                    .device = &device });
+            }
+
+            models.push_back(keyed_occurrence{
+                .key = std::move(model_key),
+                .inf = entry.path,
+                .hardware_id = {},
+                .device = &device });
+        }
+    }
+}
+
+/**
+ * @brief Collect hardware-ID and model occurrences of the parsed entries
+ *        that are not excluded.
+ */
+void collect_occurrences(
+    const corpus& entries,
+    const std::vector<bool>& excluded,
+    std::vector<keyed_occurrence>& hardware_ids,
+    std::vector<keyed_occurrence>& models)
+{
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!excluded[i])
+        {
+            collect_entry_occurrences(entries[i], hardware_ids, models);
+        }
+    }
+
+    sort_occurrences(hardware_ids);
+    sort_occurrences(models);
+}
+
+/**
+ * @brief Merge two sorted occurrence vectors and stream a record for every
+ *        key whose set of INFs changed.
+ * @param kept Sorted occurrences of the INFs unchanged on both sides; a key
+ *        found there is never `added` or `removed`.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, const diff_record&>
+void merge_occurrences(
+    std::span<const keyed_occurrence> before,
+    std::span<const keyed_occurrence> after,
+    std::span<const keyed_occurrence> kept,
+    std::string_view subject,
+    F& sink)
+{
+    auto old_position = before.begin();
+    auto new_position = after.begin();
+    auto kept_position = kept.begin();
+
+    while (old_position != before.end() || new_position != after.end())
+    {
+        const std::string& key =
+            new_position == after.end()
+            || (old_position != before.end() && old_position->key < new_position->key)
+            ? old_position->key
+            : new_position->key;
+
+        auto different_key = [&key](const keyed_occurrence& occurrence) { return occurrence.key != key; };
+        auto old_end = std::find_if(old_position, before.end(), different_key);
+        auto new_end = std::find_if(new_position, after.end(), different_key);
+
+        const keyed_occurrence& sample = old_position != old_end ? *old_position : *new_position;
+        diff_record record{
+            .subject = subject,
+            .change = change_kind::moved,
+            .hardware_id = sample.hardware_id,
+            .device = sample.device,
+            .from = {},
+            .to = {} };
+
+        // both groups are sorted by INF path: a set difference in each direction
+        while (old_position != old_end || new_position != new_end)
+        {
+            if (new_position == new_end
+                || (old_position != old_end && old_position->inf < new_position->inf))
+            {
+                record.from.push_back(old_position->inf);
+                ++old_position;
+            }
+            else if (old_position == old_end || new_position->inf < old_position->inf)
+            {
+                record.to.push_back(new_position->inf);
+                ++new_position;
+            }
+            else
+            {
+                ++old_position;
+                ++new_position;
+            }
+        }
+
+        if (!record.from.empty() || !record.to.empty())
+        {
+            kept_position = std::find_if(kept_position, kept.end(), [&key](const keyed_occurrence& occurrence)
+                {
+                    return occurrence.key >= key;
+                });
+
+            const bool unchanged_elsewhere = kept_position != kept.end() && kept_position->key == key;
+            if (!unchanged_elsewhere && record.from.empty())
+            {
+                record.change = change_kind::added;
+            }
+            else if (!unchanged_elsewhere && record.to.empty())
+            {
+                record.change = change_kind::removed;
+            }
+
+            sink(std::as_const(record));
+        }
+    }
+}
+
+/**
+ * @brief Compute and stream hardware-ID records, then model records.
+ *
+ * Entries of directory corpora are parsed here, on the pool, unless their
+ * content is unchanged.
+ *
+ * @param before Old snapshot; parsed in place.
+ * @param after New snapshot; parsed in place.
+ * @param pool Pool used for parsing.
+ * @param sink Callable receiving each `diff_record` as soon as it is known.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, const diff_record&>
+void diff_corpora(corpus& before, corpus& after, task_pool& pool, F&& sink)
+{
+    std::vector<bool> old_unchanged(before.size(), false);
+    std::vector<bool> new_unchanged(after.size(), false);
+
+    // one side of every unchanged pair, preferring one already parsed from
+    // an index
+    std::vector<corpus_entry*> kept;
+    {
+        std::unordered_map<std::string, size_t> old_by_path;
+        for (size_t i = 0; i < before.size(); ++i)
+        {
+            old_by_path.emplace(fold_key(before[i].path), i);
+        }
+
+        for (size_t i = 0; i < after.size(); ++i)
+        {
+            if (auto found = old_by_path.find(fold_key(after[i].path))
+                ; found != old_by_path.end()
+                && !after[i].sha256.empty()
+                && before[found->second].sha256 == after[i].sha256)
+            {
+                old_unchanged[found->second] = true;
+                new_unchanged[i] = true;
+                kept.push_back(
+                    before[found->second].manufacturers.has_value() ? &before[found->second] : &after[i]);
+            }
+        }
+    }
+
+    std::vector<corpus_entry*> pending = kept;
+    auto select_changed = [&pending](corpus& entries, const std::vector<bool>& unchanged)
+        {
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (!unchanged[i] && is_pending(entries[i]))
+                {
+                    pending.push_back(&entries[i]);
+                }
+            }
+        };
+
+    select_changed(before, old_unchanged);
+    select_changed(after, new_unchanged);
+    parse_each_entry(pool, pending, [](corpus_entry&) {});
+
+    std::vector<keyed_occurrence> old_hardware_ids;
+    std::vector<keyed_occurrence> old_models;
+    collect_occurrences(before, old_unchanged, old_hardware_ids, old_models);
+
+    std::vector<keyed_occurrence> new_hardware_ids;
+    std::vector<keyed_occurrence> new_models;
+    collect_occurrences(after, new_unchanged, new_hardware_ids, new_models);
+
+    std::vector<keyed_occurrence> kept_hardware_ids;
+    std::vector<keyed_occurrence> kept_models;
+    for (const corpus_entry* entry : kept)
+    {
+        collect_entry_occurrences(*entry, kept_hardware_ids, kept_models);
+    }
+
+    sort_occurrences(kept_hardware_ids);
+    sort_occurrences(kept_models);
+
+    merge_occurrences(old_hardware_ids, new_hardware_ids, kept_hardware_ids, "hardware_id", sink);
+    merge_occurrences(old_models, new_models, kept_models, "model", sink);
+}
@@ -0,0 +1,710 @@
+/**
+ * @file file_io.cppm
+ * @brief Thin C++23 module wrapping the Win32 file primitives needed beyond
+ *        INF parsing: read-only memory mapping, physical file identity,
+ *        batched reads through I/O rings and SHA-256 content hashing through
+ *        CNG.
+ *
+ * Design goals follow `setup_api.cppm`:
+ *  - Keep all Win32/`windows.h` exposure inside this module.
+ *  - Export RAII types with move-only ownership of Win32 handles.
+ *  - Throw exceptions on errors instead of returning error codes.
+ *
+ * Platform: Windows only. Includes directive to link with `bcrypt.lib`.
+ */
+
+module;
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <ioringapi.h>
+#include <bcrypt.h>
+#undef WIN32_LEAN_AND_MEAN
+#undef NOMINMAX
+
+#pragma comment(lib, "bcrypt.lib")
+
+export module file_io;
+
+/**
+ * @class file_identity
+ * @brief Identifies a physical file independently of the path used to reach
+ *        it: volume serial number plus NTFS file index (the Windows
+ *        counterpart of device + inode).
+ */
+export class file_identity
+{
+public:
+    std::uint64_t volume_serial;
+    std::uint64_t file_index;
+
+    friend bool operator==(const file_identity&, const file_identity&) noexcept = default;
+};
+
+template <>
+class std::hash<file_identity>
+{
+public:
+    std::size_t operator()(const file_identity& identity) const noexcept
+    {
+        return std::hash<std::uint64_t>{}(
+            identity.file_index ^ (identity.volume_serial * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+/**
+ * @class file_handle
+ * @brief RAII owner of a Win32 file handle opened for shared reading.
+ */
+class file_handle
+{
+private:
+    HANDLE handle;
+
+public:
+    explicit file_handle(const std::filesystem::path& path)
+        : handle{ CreateFileW(
+            path.native().c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            NULL) }
+    {
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open a file for reading");
+        }
+    }
+
+    ~file_handle()
+    {
+        if (handle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(handle);
+        }
+    }
+
+    file_handle(file_handle&) = delete;
+    file_handle& operator=(file_handle&) = delete;
+
+    file_handle(file_handle&& other) noexcept
+        : handle{ std::exchange(other.handle, INVALID_HANDLE_VALUE) }
+    {
+    }
+
+    HANDLE get() const noexcept
+    {
+        return handle;
+    }
+
+    file_identity identity() const
+    {
+        BY_HANDLE_FILE_INFORMATION information;
+        if (GetFileInformationByHandle(handle, &information) == FALSE)
+        {
+            throw std::runtime_error("Failed to query file identity");
+        }
+
+        return file_identity{
+            .volume_serial = information.dwVolumeSerialNumber,
+            .file_index = (std::uint64_t{ information.nFileIndexHigh } << 32) | information.nFileIndexLow };
+    }
+
+    std::uint64_t size() const
+    {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(handle, &size) == FALSE)
+        {
+            throw std::runtime_error("Failed to query file size");
+        }
+
+        return static_cast<std::uint64_t>(size.QuadPart);
+    }
+};
+
+/**
+ * @brief Resolve the physical identity of a file without reading it.
+ * @throws std::runtime_error if the file cannot be opened or queried.
+ */
+export file_identity identify_file(const std::filesystem::path& path)
+{
+    return file_handle{ path }.identity();
+}
+
+/**
+ * @class mapped_file
+ * @brief Read-only view of a whole file (`CreateFileMappingW` +
+ *        `MapViewOfFile`).
+ *
+ * Empty files are valid and expose an empty span; Win32 refuses to map
+ * zero-length files, so no mapping object is created for them.
+ *
+ * @throws std::runtime_error on Win32 failures.
+ */
+export class mapped_file
+{
+private:
+    file_handle file;
+    HANDLE mapping;
+    const std::byte* view;
+    std::uint64_t length;
+
+    void close() noexcept
+    {
+        if (view != nullptr)
+        {
+            UnmapViewOfFile(view);
+            view = nullptr;
+        }
+
+        if (mapping != NULL)
+        {
+            CloseHandle(mapping);
+            mapping = NULL;
+        }
+    }
+
+public:
+    explicit mapped_file(const std::filesystem::path& path)
+        : file{ path },
+        mapping{ NULL },
+        view{ nullptr },
+        length{ file.size() }
+    {
+        if (length == 0)
+        {
+            return;
+        }
+
+        if (length > std::numeric_limits<std::size_t>::max())
+        {
+            throw std::range_error("File is too large to be mapped");
+        }
+
+        mapping = CreateFileMappingW(file.get(), NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            throw std::runtime_error("Failed to create a file mapping");
+        }
+
+        view = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (view == nullptr)
+        {
+            close();
+            throw std::runtime_error("Failed to map a file view");
+        }
+    }
+
+    ~mapped_file()
+    {
+        close();
+    }
+
+    mapped_file(mapped_file&) = delete;
+    mapped_file& operator=(mapped_file&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept
+        : file{ std::move(other.file) },
+        mapping{ std::exchange(other.mapping, HANDLE{ NULL }) },
+        view{ std::exchange(other.view, nullptr) },
+        length{ std::exchange(other.length, 0) }
+    {
+    }
+
+    std::span<const std::byte> contents() const noexcept
+    {
+        return { view, static_cast<std::size_t>(length) };
+    }
+
+    file_identity identity() const
+    {
+        return file.identity();
+    }
+};
+
+/**
+ * @class io_ring_api
+ * @brief I/O ring entry points, resolved at run time so that the program
+ *        still starts on Windows versions without I/O rings (before
+ *        Windows 11).
+ */
+class io_ring_api
+{
+public:
+    decltype(&::CreateIoRing) create;
+    decltype(&::BuildIoRingRegisterBuffers) register_buffers;
+    decltype(&::BuildIoRingReadFile) read_file;
+    decltype(&::SubmitIoRing) submit;
+    decltype(&::PopIoRingCompletion) pop_completion;
+    decltype(&::CloseIoRing) close;
+
+    /**
+     * @return The resolved functions, or `nullptr` when I/O rings are not
+     *         available.
+     */
+    static const io_ring_api* instance() noexcept
+    {
+        static const std::optional<io_ring_api> api = resolve();
+        return api.has_value() ? &*api : nullptr;
+    }
+
+private:
+    static std::optional<io_ring_api> resolve() noexcept
+    {
+        const HMODULE module = GetModuleHandleW(L"kernelbase.dll");
+        if (module == NULL)
+        {
+            return std::nullopt;
+        }
+
+        auto find = [module]<typename F>(F& function, const char* name)
+            {
+                function = reinterpret_cast<F>(GetProcAddress(module, name));
+                return function != nullptr;
+            };
+
+        io_ring_api result{};
+        if (!find(result.create, "CreateIoRing")
+            || !find(result.register_buffers, "BuildIoRingRegisterBuffers")
+            || !find(result.read_file, "BuildIoRingReadFile")
+            || !find(result.submit, "SubmitIoRing")
+            || !find(result.pop_completion, "PopIoRingCompletion")
+            || !find(result.close, "CloseIoRing"))
+        {
+            return std::nullopt;
+        }
+
+        return result;
+    }
+};
+
+/**
+ * @class io_ring_completion
+ * @brief A finished read: the whole file, in a registered buffer that stays
+ *        valid until the completion callback returns.
+ */
+export class io_ring_completion
+{
+public:
+    std::size_t ordinal;
+    std::span<const std::byte> contents;
+    bool failed;
+};
+
+/**
+ * @class io_ring_reader
+ * @brief Reads whole files through a Win32 I/O ring, keeping up to `depth`
+ *        reads in flight.
+ *
+ * Every read targets one slot of a pool of buffers registered with the ring
+ * once, so the kernel does not probe and lock user pages per read. Opening
+ * a file and querying its size stay synchronous: I/O rings have no open
+ * operation. Files larger than a slot are refused by `submit` and have to
+ * be read some other way.
+ *
+ * Not thread-safe; use one reader per thread.
+ *
+ * @throws std::runtime_error on Win32 failures.
+ */
+export class io_ring_reader
+{
+private:
+    static constexpr UINT_PTR registration_tag{ ~UINT_PTR{ 0 } };
+
+    class slot
+    {
+    public:
+        std::optional<file_handle> file;
+        std::size_t ordinal{ 0 };
+        std::uint32_t length{ 0 };
+        bool busy{ false };
+        bool ready{ false };
+    };
+
+    const io_ring_api& api;
+    HIORING ring{ NULL };
+    std::byte* buffers{ nullptr };
+    std::uint32_t slot_size;
+    std::vector<slot> slots;
+    std::size_t busy_count{ 0 };
+    std::size_t ready_count{ 0 };
+
+    void release() noexcept
+    {
+        // a ring must not be closed while the kernel may still write into
+        // its buffers
+        while (ring != NULL && busy_count > ready_count)
+        {
+            UINT32 submitted;
+            IORING_CQE completion;
+            if (FAILED(api.submit(ring, 1, INFINITE, &submitted)))
+            {
+                break;
+            }
+
+            while (api.pop_completion(ring, &completion) == S_OK)
+            {
+                if (completion.UserData < slots.size())
+                {
+                    slots[completion.UserData].file.reset();
+                    slots[completion.UserData].busy = false;
+                    --busy_count;
+                }
+            }
+        }
+
+        if (ring != NULL)
+        {
+            api.close(ring);
+            ring = NULL;
+        }
+
+        if (buffers != nullptr)
+        {
+            VirtualFree(buffers, 0, MEM_RELEASE);
+            buffers = nullptr;
+        }
+    }
+
+    std::span<const std::byte> contents_of(std::size_t index) const noexcept
+    {
+        return { buffers + index * slot_size, slots[index].length };
+    }
+
+public:
+    /**
+     * @brief Test whether this Windows version provides I/O rings.
+     */
+    static bool is_supported() noexcept
+    {
+        return io_ring_api::instance() != nullptr;
+    }
+
+    /**
+     * @param depth Number of reads in flight, and of buffers.
+     * @param slot_size Size of each buffer: the largest file read.
+     * @throws std::runtime_error if I/O rings are unavailable or the ring
+     *         or its buffers cannot be set up.
+     */
+    io_ring_reader(std::uint32_t depth, std::uint32_t slot_size)
+        : api{ io_ring_api::instance() != nullptr
+            ? *io_ring_api::instance()
+            : throw std::runtime_error("I/O rings are not supported") },
+        slot_size{ slot_size },
+        slots(std::max<std::uint32_t>(depth, 1))
+    {
+        const IORING_CREATE_FLAGS flags{
+            .Required = IORING_CREATE_REQUIRED_FLAGS_NONE,
+            .Advisory = IORING_CREATE_ADVISORY_FLAGS_NONE };
+
+        const auto entries = static_cast<UINT32>(slots.size());
+        if (FAILED(api.create(IORING_VERSION_1, flags, entries, entries * 2, &ring)))
+        {
+            ring = NULL;
+            throw std::runtime_error("Failed to create an I/O ring");
+        }
+
+        buffers = static_cast<std::byte*>(VirtualAlloc(NULL, slots.size() * slot_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        if (buffers == nullptr)
+        {
+            release();
+            throw std::runtime_error("Failed to allocate I/O ring buffers");
+        }
+
+        std::vector<IORING_BUFFER_INFO> registrations(slots.size());
+        for (std::size_t i = 0; i < registrations.size(); ++i)
+        {
+            registrations[i] = IORING_BUFFER_INFO{ .Address = buffers + i * slot_size, .Length = slot_size };
+        }
+
+        UINT32 submitted;
+        IORING_CQE completion;
+        if (FAILED(api.register_buffers(ring, entries, registrations.data(), registration_tag))
+            || FAILED(api.submit(ring, 1, INFINITE, &submitted))
+            || api.pop_completion(ring, &completion) != S_OK
+            || FAILED(completion.ResultCode))
+        {
+            release();
+            throw std::runtime_error("Failed to register I/O ring buffers");
+        }
+    }
+
+    ~io_ring_reader()
+    {
+        release();
+    }
+
+    io_ring_reader(io_ring_reader&) = delete;
+    io_ring_reader& operator=(io_ring_reader&) = delete;
+
+    std::uint32_t buffer_size() const noexcept
+    {
+        return slot_size;
+    }
+
+    std::size_t depth() const noexcept
+    {
+        return slots.size();
+    }
+
+    bool full() const noexcept
+    {
+        return busy_count == slots.size();
+    }
+
+    std::size_t in_flight() const noexcept
+    {
+        return busy_count;
+    }
+
+    /**
+     * @brief Open a file and queue a read of all of it. Requires `!full()`.
+     * @return `false` if the file is larger than a buffer; nothing is
+     *         queued then.
+     * @throws std::runtime_error if the file cannot be opened or the read
+     *         cannot be queued.
+     */
+    bool submit(std::size_t ordinal, const std::filesystem::path& path)
+    {
+        file_handle file{ path };
+        const std::uint64_t length = file.size();
+        if (length > slot_size)
+        {
+            return false;
+        }
+
+        const std::size_t index = static_cast<std::size_t>(
+            std::ranges::find(slots, false, &slot::busy) - slots.begin());
+
+        slot& target = slots[index];
+        if (length != 0
+            && FAILED(api.read_file(
+                ring,
+                IoRingHandleRefFromHandle(file.get()),
+                IoRingBufferRefFromIndexAndOffset(static_cast<UINT32>(index), 0),
+                static_cast<UINT32>(length),
+                0,
+                index,
+                IOSQE_FLAGS_NONE)))
+        {
+            throw std::runtime_error("Failed to queue an I/O ring read");
+        }
+
+        target.file.emplace(std::move(file));
+        target.ordinal = ordinal;
+        target.length = static_cast<std::uint32_t>(length);
+        target.busy = true;
+        target.ready = length == 0;
+
+        ++busy_count;
+        ready_count += target.ready ? 1 : 0;
+        return true;
+    }
+
+    /**
+     * @brief Submit the queued reads, wait for at least one to finish and
+     *        report every finished read. Requires `in_flight() != 0`.
+     * @param sink Callable receiving each `const io_ring_completion&`; the
+     *        buffer is reused once it returns.
+     */
+    template <typename F>
+    requires std::is_invocable_v<F&, const io_ring_completion&>
+    void complete(F&& sink)
+    {
+        auto finish = [&](std::size_t index, bool failed)
+            {
+                slot& source = slots[index];
+                const io_ring_completion completion{
+                    .ordinal = source.ordinal,
+                    .contents = failed ? std::span<const std::byte>{} : contents_of(index),
+                    .failed = failed };
+
+                source.file.reset();
+                source.busy = false;
+                --busy_count;
+                sink(completion);
+            };
+
+        // empty files never reach the ring
+        const std::size_t immediate = ready_count;
+        for (std::size_t index = 0; ready_count != 0 && index < slots.size(); ++index)
+        {
+            if (slots[index].busy && slots[index].ready)
+            {
+                slots[index].ready = false;
+                --ready_count;
+                finish(index, false);
+            }
+        }
+
+        UINT32 submitted;
+        if (FAILED(api.submit(ring, immediate == 0 && busy_count != 0 ? 1 : 0, INFINITE, &submitted)))
+        {
+            throw std::runtime_error("Failed to submit I/O ring reads");
+        }
+
+        IORING_CQE completion;
+        while (api.pop_completion(ring, &completion) == S_OK)
+        {
+            const auto index = static_cast<std::size_t>(completion.UserData);
+            finish(index, FAILED(completion.ResultCode) || completion.Information != slots[index].length);
+        }
+    }
+};
+
+/**
+ * @typedef sha256_digest
+ * @brief Raw 32-byte SHA-256 digest.
+ */
+export using sha256_digest = std::array<std::uint8_t, 32>;
+
+/**
+ * @class sha256_provider
+ * @brief Process-wide CNG algorithm handle. CNG algorithm providers are
+ *        thread-safe for creating hash objects, so one instance is shared.
+ */
+class sha256_provider
+{
+private:
+    BCRYPT_ALG_HANDLE handle;
+
+public:
+    sha256_provider()
+        : handle{ NULL }
+    {
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&handle, BCRYPT_SHA256_ALGORITHM, NULL, 0)))
+        {
+            throw std::runtime_error("Failed to open the SHA-256 algorithm provider");
+        }
+    }
+
+    ~sha256_provider()
+    {
+        BCryptCloseAlgorithmProvider(handle, 0);
+    }
+
+    sha256_provider(sha256_provider&) = delete;
+    sha256_provider& operator=(sha256_provider&) = delete;
+
+    BCRYPT_ALG_HANDLE get() const noexcept
+    {
+        return handle;
+    }
+
+    static const sha256_provider& instance()
+    {
+        static const sha256_provider provider;
+        return provider;
+    }
+};
+
+/**
+ * @class sha256_hasher
+ * @brief Incremental SHA-256 over data fed in pieces, for content that is
+ *        never whole in memory, such as an index streamed to stdout.
+ * @throws std::runtime_error on CNG failures.
+ */
+export class sha256_hasher
+{
+private:
+    BCRYPT_HASH_HANDLE hash;
+
+public:
+    sha256_hasher()
+        : hash{ NULL }
+    {
+        if (!BCRYPT_SUCCESS(BCryptCreateHash(sha256_provider::instance().get(), &hash, NULL, 0, NULL, 0, 0)))
+        {
+            throw std::runtime_error("Failed to create a SHA-256 hash object");
+        }
+    }
+
+    ~sha256_hasher()
+    {
+        BCryptDestroyHash(hash);
+    }
+
+    sha256_hasher(sha256_hasher&) = delete;
+    sha256_hasher& operator=(sha256_hasher&) = delete;
+
+    void update(std::span<const std::byte> data)
+    {
+        while (!data.empty())
+        {
+            // BCryptHashData takes a ULONG length, so large views are fed in chunks
+            std::size_t chunk = std::min<std::size_t>(data.size(), std::numeric_limits<ULONG>::max());
+            if (!BCRYPT_SUCCESS(BCryptHashData(
+                    hash,
+                    const_cast<PUCHAR>(reinterpret_cast<const UCHAR*>(data.data())),
+                    static_cast<ULONG>(chunk),
+                    0)))
+            {
+                throw std::runtime_error("Failed to compute a SHA-256 digest");
+            }
+
+            data = data.subspan(chunk);
+        }
+    }
+
+    /**
+     * @brief Digest of everything fed so far; the hasher cannot be fed
+     *        afterwards.
+     */
+    sha256_digest finish()
+    {
+        sha256_digest digest{};
+        if (!BCRYPT_SUCCESS(BCryptFinishHash(hash, digest.data(), static_cast<ULONG>(digest.size()), 0)))
+        {
+            throw std::runtime_error("Failed to compute a SHA-256 digest");
+        }
+
+        return digest;
+    }
+};
+
+/**
+ * @brief Compute the SHA-256 digest of a memory range.
+ * @throws std::runtime_error on CNG failures.
+ */
+export sha256_digest sha256(std::span<const std::byte> data)
+{
+    sha256_hasher hasher;
+    hasher.update(data);
+    return hasher.finish();
+}
+
+/**
+ * @brief Format a digest as lowercase hexadecimal.
+ */
+export std::string to_hex(const sha256_digest& digest)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string result;
+    result.reserve(digest.size() * 2);
+    for (std::uint8_t value : digest)
+    {
+        result.push_back(digits[value >> 4]);
+        result.push_back(digits[value & 0x0F]);
+    }
+
+    return result;
+}
@@ -0,0 +1,254 @@
+/**
+ * @file hardware_id.h
+ * @brief Decomposition of hardware IDs into typed bus fields.
+ *
+ * Recognized forms:
+ *  - `PCI\VEN_vvvv&DEV_dddd[&SUBSYS_ssssssss][&REV_rr]`
+ *  - `USB\VID_vvvv&PID_pppp[&REV_rrrr][&MI_ii]`
+ *  - `HDAUDIO\FUNC_ff&VEN_vvvv&DEV_dddd[&SUBSYS_ssssssss][&REV_rrrr]`
+ *  - `ACPI\VEN_aaaa&DEV_dddd`, `ACPI\aaaadddd` and `*aaadddd` (PnP IDs)
+ *
+ * Tokens may appear in any order; unknown tokens (`CC_`, ...) are skipped
+ * and a malformed value leaves its field unset. Anything else decodes to
+ * `hardware_id_bus::other` with no fields.
+ */
+
+/**
+ * @enum hardware_id_bus
+ * @brief Bus enumerator of a hardware ID.
+ */
+enum class hardware_id_bus : std::uint8_t
+{
+    other,
+    pci,
+    usb,
+    acpi,
+    hdaudio
+};
+
+/**
+ * @class decoded_hardware_id
+ * @brief Numeric fields of a hardware ID, 20 bytes in all.
+ *
+ * `fields` tells which members were decoded. `function` is the USB
+ * interface (`MI_`) or the HD Audio function group (`FUNC_`); `acpi_vendor`
+ * holds the 3 or 4 character ACPI/PnP vendor, zero-padded.
+ */
+class decoded_hardware_id
+{
+public:
+    static constexpr std::uint8_t has_vendor{ 0x01 };
+    static constexpr std::uint8_t has_device{ 0x02 };
+    static constexpr std::uint8_t has_subsystem{ 0x04 };
+    static constexpr std::uint8_t has_revision{ 0x08 };
+    static constexpr std::uint8_t has_function{ 0x10 };
+    static constexpr std::uint8_t has_acpi_vendor{ 0x20 };
+
+    std::uint32_t subsystem{ 0 };
+    std::array<char, 4> acpi_vendor{};
+    std::uint16_t vendor{ 0 };
+    std::uint16_t device{ 0 };
+    std::uint16_t revision{ 0 };
+    hardware_id_bus bus{ hardware_id_bus::other };
+    std::uint8_t fields{ 0 };
+    std::uint8_t function{ 0 };
+
+    bool has(std::uint8_t field) const noexcept
+    {
+        return (fields & field) != 0;
+    }
+};
+
+/**
+ * @brief ASCII case-insensitive comparison with an upper-case literal.
+ */
+constexpr bool equals_ascii_upper(std::string_view text, std::string_view upper) noexcept
+{
+    return std::ranges::equal(text, upper, [](char left, char right)
+        {
+            return (left >= 'a' && left <= 'z' ? static_cast<char>(left - 'a' + 'A') : left) == right;
+        });
+}
+
+/**
+ * @brief Parse a hexadecimal value of at most `max_digits` digits that spans
+ *        the whole text.
+ */
+template <typename T>
+bool parse_hex_field(std::string_view text, size_t max_digits, T& value) noexcept
+{
+    if (text.empty() || text.size() > max_digits)
+    {
+        return false;
+    }
+
+    const char* end = text.data() + text.size();
+    auto [last, error] = std::from_chars(text.data(), end, value, 16);
+    return error == std::errc{} && last == end;
+}
+
+/**
+ * @brief Store a 3 or 4 character ACPI/PnP vendor prefix.
+ */
+bool parse_acpi_vendor(std::string_view text, decoded_hardware_id& result) noexcept
+{
+    if (text.size() < 3 || text.size() > result.acpi_vendor.size()
+        || !std::ranges::all_of(text, [](char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_'; }))
+    {
+        return false;
+    }
+
+    std::ranges::transform(text, result.acpi_vendor.begin(), [](char c)
+        {
+            return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+        });
+    result.fields |= decoded_hardware_id::has_acpi_vendor;
+    return true;
+}
+
+/**
+ * @brief Decode the compact ACPI/PnP form: a vendor prefix followed by four
+ *        hexadecimal product digits (`PNP0A08`, `ASUS2018`).
+ */
+void decode_compact_acpi_id(std::string_view text, decoded_hardware_id& result) noexcept
+{
+    static constexpr size_t product_digits{ 4 };
+
+    if (text.size() <= product_digits)
+    {
+        return;
+    }
+
+    const std::string_view product = text.substr(text.size() - product_digits);
+    decoded_hardware_id candidate = result;
+    if (parse_acpi_vendor(text.substr(0, text.size() - product_digits), candidate)
+        && parse_hex_field(product, product_digits, candidate.device))
+    {
+        candidate.fields |= decoded_hardware_id::has_device;
+        result = candidate;
+    }
+}
+
+/**
+ * @brief Decode one `NAME_value` token of an `&`-separated hardware ID.
+ */
+void decode_hardware_id_token(std::string_view token, decoded_hardware_id& result) noexcept
+{
+    const size_t separator = token.find('_');
+    if (separator == std::string_view::npos)
+    {
+        return;
+    }
+
+    const std::string_view name = token.substr(0, separator);
+    const std::string_view value = token.substr(separator + 1);
+
+    if (equals_ascii_upper(name, "VEN") && result.bus == hardware_id_bus::acpi)
+    {
+        parse_acpi_vendor(value, result);
+    }
+    else if (equals_ascii_upper(name, "VEN") || equals_ascii_upper(name, "VID"))
+    {
+        if (parse_hex_field(value, 4, result.vendor))
+        {
+            result.fields |= decoded_hardware_id::has_vendor;
+        }
+    }
+    else if (equals_ascii_upper(name, "DEV") || equals_ascii_upper(name, "PID"))
+    {
+        if (parse_hex_field(value, 4, result.device))
+        {
+            result.fields |= decoded_hardware_id::has_device;
+        }
+    }
+    else if (equals_ascii_upper(name, "SUBSYS"))
+    {
+        if (parse_hex_field(value, 8, result.subsystem))
+        {
+            result.fields |= decoded_hardware_id::has_subsystem;
+        }
+    }
+    else if (equals_ascii_upper(name, "REV"))
+    {
+        if (parse_hex_field(value, 4, result.revision))
+        {
+            result.fields |= decoded_hardware_id::has_revision;
+        }
+    }
+    else if (equals_ascii_upper(name, "MI") || equals_ascii_upper(name, "FUNC"))
+    {
+        if (parse_hex_field(value, 2, result.function))
+        {
+            result.fields |= decoded_hardware_id::has_function;
+        }
+    }
+}
+
+/**
+ * @brief Classify a hardware ID by bus and decode its hexadecimal fields.
+ * @param text Hardware or compatible ID as reported (UTF-8).
+ */
+decoded_hardware_id decode_hardware_id(std::string_view text) noexcept
+{
+    static constexpr std::pair<std::string_view, hardware_id_bus> enumerators[]{
+        { "PCI", hardware_id_bus::pci },
+        { "USB", hardware_id_bus::usb },
+        { "ACPI", hardware_id_bus::acpi },
+        { "HDAUDIO", hardware_id_bus::hdaudio }
+    };
+
+    decoded_hardware_id result;
+
+    if (text.starts_with('*'))
+    {
+        result.bus = hardware_id_bus::acpi;
+        decode_compact_acpi_id(text.substr(1), result);
+        return result;
+    }
+
+    const size_t separator = text.find('\\');
+    if (separator == std::string_view::npos)
+    {
+        return result;
+    }
+
+    const std::string_view enumerator = text.substr(0, separator);
+    auto found = std::ranges::find_if(enumerators, [enumerator](const auto& item) { return equals_ascii_upper(enumerator, item.first); });
+    if (found == std::ranges::end(enumerators))
+    {
+        return result;
+    }
+
+    result.bus = found->second;
+
+    std::string_view rest = text.substr(separator + 1);
+    if (result.bus == hardware_id_bus::acpi && rest.find('&') == std::string_view::npos && rest.find('_') == std::string_view::npos)
+    {
+        decode_compact_acpi_id(rest, result);
+        return result;
+    }
+
+    while (!rest.empty())
+    {
+        const size_t delimiter = rest.find('&');
+        decode_hardware_id_token(rest.substr(0, delimiter), result);
+        rest.remove_prefix(delimiter == std::string_view::npos ? rest.size() : delimiter + 1);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Decode every ID of a list, in order.
+ */
+std::vector<decoded_hardware_id> decode_hardware_ids(const std::vector<std::string>& hardware_ids)
+{
+    std::vector<decoded_hardware_id> result;
+    result.reserve(hardware_ids.size());
+    for (const std::string& hardware_id : hardware_ids)
+    {
+        result.push_back(decode_hardware_id(hardware_id));
+    }
+
+    return result;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file incremental.h
+ * @brief Incremental report rebuilds for an INF that is being edited.
+ *
+ * SetupAPI has no partial parsing, so every rebuild still opens the whole
+ * INF. What is skipped is the work on top of it: the raw text of every
+ * section is hashed straight from the mapped file, and a manufacturer whose
+ * `[Manufacturer]` line, models sections and `[Strings]` tables hash the
+ * same as in the previous rebuild keeps its report entry; its models
+ * sections are neither enumerated, deduplicated nor converted again.
+ */
+
+/**
+ * @typedef section_hashes
+ * @brief Hash of the raw body of each section, keyed case-insensitively.
+ *        A section that appears several times combines all of its bodies.
+ */
+using section_hashes = std::unordered_map<section_name, std::uint64_t>;
+
+/**
+ * @brief Split raw INF text at `[section]` headers and hash each body.
+ *
+ * Only header lines are recognized; the bodies are hashed as opaque bytes,
+ * so comment or whitespace edits count as changes, which is conservative.
+ *
+ * @tparam char_type `char` for ANSI/UTF-8 files, `wchar_t` for UTF-16LE.
+ */
+template <typename char_type>
+section_hashes hash_raw_sections(std::span<const char_type> text)
+{
+    using unsigned_char_type = std::make_unsigned_t<char_type>;
+
+    static constexpr char_type line_feed = '\n';
+    static constexpr char_type open_bracket = '[';
+    static constexpr char_type close_bracket = ']';
+
+    auto is_blank = [](char_type c) { return c == char_type{ ' ' } || c == char_type{ '\t' } || c == char_type{ '\r' }; };
+
+    section_hashes result;
+    std::optional<section_name> current;
+    size_t body_start{ 0 };
+
+    auto flush = [&](size_t body_end)
+        {
+            if (!current.has_value())
+            {
+                return;
+            }
+
+            std::span<const char_type> body = text.subspan(body_start, body_end - body_start);
+            std::uint64_t body_hash = std::hash<std::string_view>{}(
+                std::string_view{ reinterpret_cast<const char*>(body.data()), body.size_bytes() });
+
+            if (auto [existing, inserted] = result.try_emplace(*current, body_hash)
+                ; !inserted)
+            {
+                existing->second = combine_hash(existing->second, body_hash);
+            }
+        };
+
+    size_t position{ 0 };
+    while (position < text.size())
+    {
+        const auto line_begin = text.begin() + position;
+        const size_t line_end = static_cast<size_t>(std::find(line_begin, text.end(), line_feed) - text.begin());
+
+        size_t first = position;
+        while (first < line_end && is_blank(text[first]))
+        {
+            ++first;
+        }
+
+        if (first < line_end && text[first] == open_bracket)
+        {
+            const auto close = std::find(text.begin() + first + 1, text.begin() + line_end, close_bracket);
+            if (close != text.begin() + line_end)
+            {
+                flush(position);
+
+                section_name name;
+                for (auto c = text.begin() + first + 1; c != close; ++c)
+                {
+                    name.push_back(static_cast<wchar_t>(static_cast<unsigned_char_type>(*c)));
+                }
+
+                const size_t name_begin = name.find_first_not_of(L" \t");
+                const size_t name_end = name.find_last_not_of(L" \t");
+                current = name_begin == section_name::npos
+                    ? section_name{}
+                    : name.substr(name_begin, name_end - name_begin + 1);
+                body_start = std::min(line_end + 1, text.size());
+            }
+        }
+
+        position = line_end + 1;
+    }
+
+    flush(text.size());
+    return result;
+}
+
+/**
+ * @brief Hash the sections of a mapped INF, detecting UTF-16LE and UTF-8
+ *        byte order marks.
+ */
+section_hashes hash_raw_sections(std::span<const std::byte> content)
+{
+    return visit_inf_text(content, [](auto text) { return hash_raw_sections(text); });
+}
+
+/**
+ * @brief Combined hash of `[Strings]` and its locale decorations, which feed
+ *        `%strkey%` expansion everywhere. Order-independent.
+ */
+std::uint64_t hash_string_tables(const section_hashes& sections)
+{
+    static constexpr section_name_view strings{ L"Strings" };
+    static constexpr wchar_t delimiter = '.';
+
+    std::uint64_t result{ 0 };
+    for (const auto& [name, body_hash] : sections)
+    {
+        if (name.size() >= strings.size()
+            && section_name_view{ name }.substr(0, strings.size()) == strings
+            && (name.size() == strings.size() || name[strings.size()] == delimiter))
+        {
+            result ^= combine_hash(std::hash<section_name>{}(name), body_hash);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @class manufacturer_signature
+ * @brief Everything a manufacturer's report entry is computed from, except
+ *        the string tables: its `[Manufacturer]` line and the raw hashes of
+ *        its resolved models sections. A models section whose raw text was not
+ *        found has no hash and makes the signature never match.
+ */
+class manufacturer_signature
+{
+public:
+    key_name name;
+    section_name models_section_name;
+    std::vector<std::wstring> architectures;
+    std::vector<std::pair<section_name, std::optional<std::uint64_t>>> models_sections;
+
+    bool is_complete() const noexcept
+    {
+        return std::ranges::all_of(models_sections, [](const auto& section) { return section.second.has_value(); });
+    }
+
+    friend bool operator==(const manufacturer_signature&, const manufacturer_signature&) = default;
+};
+
+/**
+ * @class incremental_report
+ * @brief Report builder that reuses the manufacturers of the previous build
+ *        whose inputs did not change.
+ *
+ * The state is the previous build only; the first call is a full build.
+ */
+class incremental_report
+{
+public:
+    /**
+     * @class statistics
+     * @brief Outcome of the last `rebuild`.
+     */
+    class statistics
+    {
+    public:
+        size_t reused;
+        size_t rebuilt;
+    };
+
+private:
+    class cached_manufacturer
+    {
+    public:
+        manufacturer_signature signature;
+        manufacturer entry;
+    };
+
+    std::optional<std::uint64_t> string_tables;
+    std::vector<cached_manufacturer> cache;
+    statistics last{ .reused = 0, .rebuilt = 0 };
+
+public:
+    /**
+     * @brief Rebuild the report of an INF, reusing unchanged manufacturers.
+     *        The INF is checked against the parse limits first.
+     * @throws limit_exceeded if the INF is over a limit.
+     * @throws std::exception on Win32 or parsing failures; the previous state
+     *         is kept in that case.
+     */
+    report rebuild(const std::filesystem::path& inf_path, const parse_limits& limits = {})
+    {
+        section_hashes raw_sections;
+        {
+            mapped_file content{ inf_path };
+            check_parse_limits(content.contents(), limits);
+            raw_sections = hash_raw_sections(content.contents());
+        }
+
+        const std::uint64_t strings_hash = hash_string_tables(raw_sections);
+        const bool strings_unchanged = string_tables == strings_hash;
+
+        inf_file inf{ inf_path };
+        const std::unordered_set<section_name> all_sections = extract_sections(inf);
+
+        std::vector<cached_manufacturer> updated;
+        statistics current{ .reused = 0, .rebuilt = 0 };
+        for (auto& inf_manufacturer : extract_manufacturers(inf))
+        {
+            manufacturer_signature signature{
+                .name = inf_manufacturer.name,
+                .models_section_name = inf_manufacturer.models_section_name,
+                .architectures = inf_manufacturer.architectures,
+                .models_sections = {} };
+
+            for (models_sections_correlation correlation : correlate_models_sections(inf_manufacturer, all_sections))
+            {
+                auto found = raw_sections.find(correlation.models_section);
+                signature.models_sections.emplace_back(
+                    std::move(correlation.models_section),
+                    found != raw_sections.end() ? std::optional{ found->second } : std::nullopt);
+            }
+
+            auto previous = strings_unchanged && signature.is_complete()
+                ? std::ranges::find(cache, signature, &cached_manufacturer::signature)
+                : cache.end();
+
+            if (previous != cache.end())
+            {
+                updated.push_back(*previous);
+                ++current.reused;
+            }
+            else
+            {
+                updated.push_back(cached_manufacturer{
+                    .signature = std::move(signature),
+                    .entry = select_manufacturer_data(inf, inf_manufacturer, all_sections) });
+                ++current.rebuilt;
+            }
+        }
+
+        report output;
+        output.reserve(updated.size());
+        for (const cached_manufacturer& item : updated)
+        {
+            output.push_back(item.entry);
+        }
+
+        string_tables = strings_hash;
+        cache = std::move(updated);
+        last = current;
+        return output;
+    }
+
+    const statistics& last_statistics() const noexcept
+    {
+        return last;
+    }
+};
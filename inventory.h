@@ -0,0 +1,351 @@
+/**
+ * @file inventory.h
+ * @brief Fleet inventory join: which devices of many machines have a driver
+ *        in a corpus.
+ *
+ * An inventory is a JSON Lines file, one machine per line:
+ *
+ * ```json
+ * {"machine":"PC-0001","devices":[{"id":"PCI\\VEN_8086&DEV_A0F0\\3&11583659&0&A0",
+ *   "hardware_ids":["PCI\\VEN_8086&DEV_A0F0&SUBSYS_00748086&REV_20", ...],
+ *   "compatible_ids":["PCI\\VEN_8086&DEV_A0F0&REV_20", ...]}]}
+ * ```
+ *
+ * Inventories are highly redundant, so the join works on distinct IDs: all
+ * device IDs are folded and deduplicated through a hash map and only the
+ * distinct ones are sorted, the corpus is turned into a sorted dictionary of
+ * folded IDs, and the two sorted lists are intersected once with galloping
+ * search. Results are then fanned back out to every device through the ID
+ * ordinals.
+ */
+
+/**
+ * @class inventory_device
+ * @brief One device of a machine. `ids` holds ordinals into the distinct
+ *        inventory IDs: hardware IDs first, then compatible IDs, in the order
+ *        reported.
+ */
+class inventory_device
+{
+public:
+    std::string id;
+    std::vector<std::string> hardware_ids;
+    std::vector<std::string> compatible_ids;
+    std::vector<std::uint32_t> ids;
+};
+
+/**
+ * @class inventory_machine
+ * @brief A machine and its devices.
+ */
+class inventory_machine
+{
+public:
+    std::string name;
+    std::vector<inventory_device> devices;
+};
+
+/**
+ * @class inventory
+ * @brief Machines plus the sorted, distinct folded IDs of all their devices.
+ */
+class inventory
+{
+public:
+    std::vector<inventory_machine> machines;
+    std::vector<std::string> keys;
+};
+
+/**
+ * @brief Read an inventory and index the IDs of its devices.
+ * @throws nlohmann::json::exception on malformed lines.
+ */
+inventory read_inventory(std::istream& input)
+{
+    inventory result;
+
+    std::string text;
+    while (std::getline(input, text))
+    {
+        if (is_blank_index_line(text))
+        {
+            continue;
+        }
+
+        const nlohmann::json item = nlohmann::json::parse(text);
+
+        inventory_machine machine{ .name = item.at("machine").get<std::string>(), .devices = {} };
+        for (const auto& device : item.at("devices"))
+        {
+            machine.devices.push_back(inventory_device{
+                .id = device.value("id", std::string{}),
+                .hardware_ids = device.value("hardware_ids", std::vector<std::string>{}),
+                .compatible_ids = device.value("compatible_ids", std::vector<std::string>{}),
+                .ids = {} });
+        }
+
+        result.machines.push_back(std::move(machine));
+    }
+
+    // number the distinct IDs as they are met, so each ID is folded once and
+    // only distinct IDs are sorted; ordinals are then remapped to sorted
+    // order
+    std::unordered_map<std::string, std::uint32_t> ordinals;
+    for (inventory_machine& machine : result.machines)
+    {
+        for (inventory_device& device : machine.devices)
+        {
+            device.ids.reserve(device.hardware_ids.size() + device.compatible_ids.size());
+            for (const auto* list : { &device.hardware_ids, &device.compatible_ids })
+            {
+                for (const std::string& hardware_id : *list)
+                {
+                    auto [position, inserted] = ordinals.try_emplace(fold_key(hardware_id), static_cast<std::uint32_t>(ordinals.size()));
+                    device.ids.push_back(position->second);
+                }
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, std::uint32_t>> distinct{ ordinals.begin(), ordinals.end() };
+    ordinals.clear();
+    std::ranges::sort(distinct);
+
+    std::vector<std::uint32_t> sorted_ordinals(distinct.size());
+    result.keys.reserve(distinct.size());
+    for (auto& [key, ordinal] : distinct)
+    {
+        sorted_ordinals[ordinal] = static_cast<std::uint32_t>(result.keys.size());
+        result.keys.push_back(std::move(key));
+    }
+
+    for (inventory_machine& machine : result.machines)
+    {
+        for (inventory_device& device : machine.devices)
+        {
+            for (std::uint32_t& id : device.ids)
+            {
+                id = sorted_ordinals[id];
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @class hardware_id_dictionary
+ * @brief Sorted, distinct folded IDs of a corpus with their postings;
+ *        `postings[offsets[i] .. offsets[i + 1])` belong to `keys[i]`.
+ */
+class hardware_id_dictionary
+{
+public:
+    std::vector<std::string> keys;
+    std::vector<std::uint32_t> offsets;
+    std::vector<hardware_id_posting> postings;
+
+    std::span<const hardware_id_posting> postings_of(size_t key) const
+    {
+        return std::span{ postings }.subspan(offsets[key], offsets[key + 1] - offsets[key]);
+    }
+};
+
+/**
+ * @brief Build the dictionary of every parsed entry of a corpus.
+ */
+hardware_id_dictionary build_hardware_id_dictionary(const corpus& entries)
+{
+    std::vector<std::pair<std::string, hardware_id_posting>> occurrences;
+    for (size_t entry = 0; entry < entries.size(); ++entry)
+    {
+        if (!entries[entry].manufacturers.has_value())
+        {
+            continue;
+        }
+
+        const report& manufacturers = *entries[entry].manufacturers;
+        for (size_t maker = 0; maker < manufacturers.size(); ++maker)
+        {
+            const std::vector<model>& devices = manufacturers[maker].devices;
+            for (size_t device = 0; device < devices.size(); ++device)
+            {
+                const std::vector<std::string>& hardware_ids = devices[device].hardware_ids;
+                for (size_t id = 0; id < hardware_ids.size(); ++id)
+                {
+                    occurrences.emplace_back(fold_key(hardware_ids[id]), hardware_id_posting{
+                        .entry = static_cast<std::uint32_t>(entry),
+                        .manufacturer = static_cast<std::uint32_t>(maker),
+                        .device = static_cast<std::uint32_t>(device),
+                        .hardware_id = static_cast<std::uint32_t>(id) });
+                }
+            }
+        }
+    }
+
+    std::ranges::stable_sort(occurrences, std::less{}, &std::pair<std::string, hardware_id_posting>::first);
+
+    hardware_id_dictionary result;
+    result.postings.reserve(occurrences.size());
+    for (auto& [key, posting] : occurrences)
+    {
+        if (result.keys.empty() || result.keys.back() != key)
+        {
+            result.keys.push_back(std::move(key));
+            result.offsets.push_back(static_cast<std::uint32_t>(result.postings.size()));
+        }
+
+        result.postings.push_back(posting);
+    }
+
+    result.offsets.push_back(static_cast<std::uint32_t>(result.postings.size()));
+    return result;
+}
+
+/**
+ * @brief First position at or after `first` whose key is not less than
+ *        `key`: exponential probing from `first`, then a binary search of the
+ *        last step, so short skips cost O(log distance).
+ */
+size_t gallop_lower_bound(std::span<const std::string> keys, size_t first, std::string_view key)
+{
+    size_t step{ 1 };
+    size_t bound = first;
+    while (bound < keys.size() && keys[bound] < key)
+    {
+        first = bound + 1;
+        bound += step;
+        step *= 2;
+    }
+
+    const auto end = keys.begin() + static_cast<ptrdiff_t>(std::min(bound, keys.size()));
+    return static_cast<size_t>(std::lower_bound(keys.begin() + static_cast<ptrdiff_t>(first), end, key) - keys.begin());
+}
+
+/**
+ * @brief Intersect two sorted, distinct key lists.
+ * @return For each left key, the index of the equal right key, if any.
+ */
+std::vector<std::optional<std::uint32_t>> intersect_sorted_keys(
+    std::span<const std::string> left,
+    std::span<const std::string> right)
+{
+    std::vector<std::optional<std::uint32_t>> result(left.size());
+
+    size_t i{ 0 };
+    size_t j{ 0 };
+    while (i < left.size() && j < right.size())
+    {
+        if (left[i] < right[j])
+        {
+            i = gallop_lower_bound(left, i, right[j]);
+        }
+        else if (right[j] < left[i])
+        {
+            j = gallop_lower_bound(right, j, left[i]);
+        }
+        else
+        {
+            result[i] = static_cast<std::uint32_t>(j);
+            ++i;
+            ++j;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @class device_coverage
+ * @brief Join result of one device: the first of its IDs (hardware IDs
+ *        first) found in the corpus and the INFs listing it. Views point into
+ *        the inventory and the corpus.
+ */
+class device_coverage
+{
+public:
+    const inventory_device* device;
+    std::string_view matched_id;
+    std::vector<std::string_view> infs;
+};
+
+/**
+ * @class machine_coverage
+ * @brief Join result of one machine.
+ */
+class machine_coverage
+{
+public:
+    const inventory_machine* machine;
+    std::vector<device_coverage> devices;
+    size_t covered;
+};
+
+/**
+ * @class inventory_join
+ * @brief Distinct-ID join of an inventory against a corpus.
+ */
+class inventory_join
+{
+private:
+    const corpus& entries;
+    const hardware_id_dictionary& dictionary;
+    std::vector<std::optional<std::uint32_t>> matches;
+
+public:
+    inventory_join(const inventory& fleet, const corpus& entries, const hardware_id_dictionary& dictionary)
+        : entries{ entries },
+        dictionary{ dictionary },
+        matches{ intersect_sorted_keys(fleet.keys, dictionary.keys) }
+    {
+    }
+
+    /**
+     * @brief Number of distinct inventory IDs found in the corpus.
+     */
+    size_t matched_keys() const
+    {
+        return static_cast<size_t>(std::ranges::count_if(matches, [](const auto& match) { return match.has_value(); }));
+    }
+
+    /**
+     * @brief Fan the ID matches out to the devices of one machine.
+     */
+    machine_coverage cover(const inventory_machine& machine) const
+    {
+        machine_coverage result{ .machine = &machine, .devices = {}, .covered = 0 };
+        result.devices.reserve(machine.devices.size());
+
+        for (const inventory_device& device : machine.devices)
+        {
+            device_coverage coverage{ .device = &device, .matched_id = {}, .infs = {} };
+
+            for (size_t position = 0; position < device.ids.size(); ++position)
+            {
+                const std::optional<std::uint32_t>& match = matches[device.ids[position]];
+                if (!match.has_value())
+                {
+                    continue;
+                }
+
+                coverage.matched_id = position < device.hardware_ids.size()
+                    ? std::string_view{ device.hardware_ids[position] }
+                    : std::string_view{ device.compatible_ids[position - device.hardware_ids.size()] };
+
+                for (const hardware_id_posting& posting : dictionary.postings_of(*match))
+                {
+                    coverage.infs.push_back(entries[posting.entry].path);
+                }
+
+                auto repeated = std::ranges::unique(coverage.infs);
+                coverage.infs.erase(repeated.begin(), repeated.end());
+                ++result.covered;
+                break;
+            }
+
+            result.devices.push_back(std::move(coverage));
+        }
+
+        return result;
+    }
+};
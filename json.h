@@ -6,12 +6,83 @@
  * one-way serialization semantics.
  */
 
+template <>
+struct nlohmann::adl_serializer<hardware_id_bus> {
+    static void to_json(json& j, hardware_id_bus b) {
+        switch (b)
+        {
+        case hardware_id_bus::other:
+            j = "other";
+            break;
+
+        case hardware_id_bus::pci:
+            j = "pci";
+            break;
+
+        case hardware_id_bus::usb:
+            j = "usb";
+            break;
+
+        case hardware_id_bus::acpi:
+            j = "acpi";
+            break;
+
+        case hardware_id_bus::hdaudio:
+            j = "hdaudio";
+            break;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, hardware_id_bus&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<decoded_hardware_id> {
+    static void to_json(json& j, const decoded_hardware_id& d) {
+        j = json{
+            {"bus", d.bus}
+        };
+
+        if (d.has(decoded_hardware_id::has_acpi_vendor))
+        {
+            j["acpi_vendor"] = std::string{ d.acpi_vendor.begin(), std::ranges::find(d.acpi_vendor, '\0') };
+        }
+        else if (d.has(decoded_hardware_id::has_vendor))
+        {
+            j["vendor"] = d.vendor;
+        }
+
+        if (d.has(decoded_hardware_id::has_device))
+        {
+            j["device"] = d.device;
+        }
+
+        if (d.has(decoded_hardware_id::has_subsystem))
+        {
+            j["subsystem"] = d.subsystem;
+        }
+
+        if (d.has(decoded_hardware_id::has_revision))
+        {
+            j["revision"] = d.revision;
+        }
+
+        if (d.has(decoded_hardware_id::has_function))
+        {
+            j["function"] = d.function;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, decoded_hardware_id&) = delete;
+};
+
 template <>
 struct nlohmann::adl_serializer<model> {
     static void to_json(json& j, const model& m) {
         j = json{
             {"description", m.description},
             {"hardware_ids", m.hardware_ids},
+            {"decoded_hardware_ids", m.decoded_hardware_ids},
             {"architectures", m.architectures}
         };
     }
@@ -30,3 +101,346 @@ struct nlohmann::adl_serializer<manufacturer> {
 
     static void from_json(const nlohmann::json&, manufacturer&) = delete;
 };
+
+template <>
+struct nlohmann::adl_serializer<payload_file> {
+    static void to_json(json& j, const payload_file& f) {
+        j = json{
+            {"name", f.name},
+            {"path", f.path},
+            {"present", f.present}
+        };
+
+        if (f.present)
+        {
+            j["size"] = f.size;
+            j["sha256"] = f.sha256;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, payload_file&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<package_version> {
+    static void to_json(json& j, const package_version& v) {
+        j = json{
+            {"class", v.class_name},
+            {"provider", v.provider},
+            {"catalog_file", v.catalog_file},
+            {"driver_date", v.driver_date},
+            {"driver_version", v.driver_version}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, package_version&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<triage_entry> {
+    static void to_json(json& j, const triage_entry& e) {
+        j = json{ {"path", e.path} };
+
+        if (!e.triage.has_value())
+        {
+            j["error"] = e.error;
+            return;
+        }
+
+        j["class"] = e.triage->version.class_name;
+        j["class_guid"] = e.triage->class_guid;
+        j["provider"] = e.triage->version.provider;
+        j["catalog_file"] = e.triage->version.catalog_file;
+        j["driver_date"] = e.triage->version.driver_date;
+        j["driver_version"] = e.triage->version.driver_version;
+        j["has_manufacturer"] = e.triage->has_manufacturer;
+    }
+
+    static void from_json(const nlohmann::json&, triage_entry&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<parse_diagnostic> {
+    static void to_json(json& j, const parse_diagnostic& d) {
+        j = json{
+            {"section", d.section},
+            {"line", d.line},
+            {"reason", d.reason}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, parse_diagnostic&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<corpus_entry> {
+    static void to_json(json& j, const corpus_entry& e) {
+        j = json{
+            {"path", e.path},
+            {"sha256", e.sha256}
+        };
+
+        if (e.manufacturers.has_value())
+        {
+            j["manufacturers"] = *e.manufacturers;
+        }
+        else
+        {
+            j["error"] = e.error;
+        }
+
+        if (e.version.has_value())
+        {
+            j["version"] = *e.version;
+        }
+
+        if (!e.diagnostics.empty())
+        {
+            j["diagnostics"] = e.diagnostics;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, corpus_entry&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<change_kind> {
+    static void to_json(json& j, change_kind c) {
+        switch (c)
+        {
+        case change_kind::added:
+            j = "added";
+            break;
+
+        case change_kind::removed:
+            j = "removed";
+            break;
+
+        case change_kind::moved:
+            j = "moved";
+            break;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, change_kind&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<diff_record> {
+    static void to_json(json& j, const diff_record& r) {
+        j = json{
+            {"subject", std::string{ r.subject }},
+            {"change", r.change}
+        };
+
+        if (r.subject == "hardware_id")
+        {
+            j["hardware_id"] = std::string{ r.hardware_id };
+        }
+        else
+        {
+            j["description"] = r.device->description;
+            j["hardware_ids"] = r.device->hardware_ids;
+        }
+
+        if (!r.from.empty())
+        {
+            json& infs = j["from"] = json::array();
+            for (std::string_view inf : r.from)
+            {
+                infs.push_back(std::string{ inf });
+            }
+        }
+
+        if (!r.to.empty())
+        {
+            json& infs = j["to"] = json::array();
+            for (std::string_view inf : r.to)
+            {
+                infs.push_back(std::string{ inf });
+            }
+        }
+    }
+
+    static void from_json(const nlohmann::json&, diff_record&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<hardware_id_match> {
+    static void to_json(json& j, const hardware_id_match& m) {
+        j = json{
+            {"hardware_id", std::string{ m.hardware_id }}
+        };
+
+        json& occurrences = j["occurrences"] = json::array();
+        for (const hardware_id_occurrence& occurrence : m.occurrences)
+        {
+            occurrences.push_back(json{
+                {"inf", std::string{ occurrence.inf }},
+                {"manufacturer", std::string{ occurrence.manufacturer }},
+                {"description", occurrence.device->description}
+            });
+        }
+    }
+
+    static void from_json(const nlohmann::json&, hardware_id_match&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<resolved_driver> {
+    static void to_json(json& j, const resolved_driver& d) {
+        j = json{
+            {"rank", std::format("0x{:08X}", d.driver->rank)},
+            {"inf", d.entry->path},
+            {"manufacturer", d.maker->name},
+            {"description", d.device->description},
+            {"hardware_id", d.device->hardware_ids[d.driver->posting.hardware_id]},
+            {"decoration", std::string{ d.driver->decoration }}
+        };
+
+        if (d.entry->version.has_value())
+        {
+            j["signed"] = !d.entry->version->catalog_file.empty();
+            j["driver_date"] = d.entry->version->driver_date;
+            j["driver_version"] = d.entry->version->driver_version;
+        }
+        else
+        {
+            j["signed"] = false;
+        }
+    }
+
+    static void from_json(const nlohmann::json&, resolved_driver&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<index_match> {
+    static void to_json(json& j, const index_match& m) {
+        j = json{
+            {"hardware_id", std::string{ m.hardware_id }},
+            {"inf", std::string{ m.occurrence.inf }},
+            {"manufacturer", std::string{ m.occurrence.manufacturer }},
+            {"description", m.occurrence.device->description}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, index_match&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<device_coverage> {
+    static void to_json(json& j, const device_coverage& c) {
+        j = json{
+            {"id", c.device->id},
+            {"covered", !c.infs.empty()}
+        };
+
+        if (!c.infs.empty())
+        {
+            j["matched_id"] = std::string{ c.matched_id };
+
+            auto& infs = j["infs"] = json::array();
+            for (std::string_view inf : c.infs)
+            {
+                infs.push_back(std::string{ inf });
+            }
+        }
+    }
+
+    static void from_json(const nlohmann::json&, device_coverage&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<machine_coverage> {
+    static void to_json(json& j, const machine_coverage& c) {
+        j = json{
+            {"machine", c.machine->name},
+            {"covered", c.covered},
+            {"uncovered", c.devices.size() - c.covered},
+            {"devices", c.devices}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, machine_coverage&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<driver_plan> {
+    static void to_json(json& j, const driver_plan& p) {
+        auto& packages = j["packages"] = json::array();
+        for (const planned_package& package : p.packages)
+        {
+            packages.push_back(json{
+                {"inf", package.entry->path},
+                {"devices", package.devices}
+            });
+        }
+
+        auto& uncovered = j["uncovered"] = json::array();
+        for (const uncovered_device& device : p.uncovered)
+        {
+            uncovered.push_back(json{
+                {"id", device.device->id},
+                {"hardware_ids", device.device->hardware_ids},
+                {"compatible_ids", device.device->compatible_ids},
+                {"instances", device.instances}
+            });
+        }
+    }
+
+    static void from_json(const nlohmann::json&, driver_plan&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<cluster_member> {
+    static void to_json(json& j, const cluster_member& m) {
+        j = json{
+            {"inf", m.entry->path},
+            {"jaccard", m.jaccard}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, cluster_member&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<model_reference> {
+    static void to_json(json& j, const model_reference& r) {
+        j = json{
+            {"inf", r.entry->path},
+            {"manufacturer", r.manufacturer},
+            {"architectures", r.architectures}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, model_reference&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<deduplicated_model> {
+    static void to_json(json& j, const deduplicated_model& m) {
+        j = json{
+            {"description", m.description},
+            {"hardware_ids", m.hardware_ids},
+            {"references", m.references}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, deduplicated_model&) = delete;
+};
+
+template <>
+struct nlohmann::adl_serializer<queue_statistics> {
+    static void to_json(json& j, const queue_statistics& s) {
+        j = json{
+            {"capacity", s.capacity},
+            {"pushes", s.pushes},
+            {"peak_depth", s.peak_depth},
+            {"mean_depth", s.mean_depth},
+            {"full_waits", s.full_waits},
+            {"empty_waits", s.empty_waits}
+        };
+    }
+
+    static void from_json(const nlohmann::json&, queue_statistics&) = delete;
+};
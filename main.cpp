@@ -1,17 +1,71 @@
 #include <iostream>
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <ranges>
 #include <tuple>
 #include <generator>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <expected>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <stop_token>
+#include <span>
+#include <fstream>
+#include <string_view>
+#include <exception>
+#include <utility>
+#include <chrono>
+#include <type_traits>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <charconv>
+#include <cctype>
+#include <format>
+#include <queue>
+#include <bit>
+#include <atomic>
+#include <memory>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
 
 #include <nlohmann/json.hpp>
 
 import setup_api;
+import file_io;
 
 #include "reader.h"
+#include "hardware_id.h"
 #include "report.h"
+#include "parse_limits.h"
+#include "parallel.h"
+#include "manifest.h"
+#include "snapshot.h"
+#include "corpus.h"
+#include "diff.h"
+#include "trie.h"
+#include "bloom.h"
+#include "ranking.h"
+#include "inventory.h"
+#include "planner.h"
+#include "cluster.h"
+#include "dedup.h"
+#include "incremental.h"
 #include "json.h"
+#include "pipeline.h"
+#include "command_line.h"
 
 enum class exit_codes : int
 {
@@ -22,25 +76,518 @@ enum class exit_codes : int
     out_of_memory
 };
 
+/**
+ * @brief Print the report of an INF source, optionally with the payload
+ *        manifest next to it. With `--lenient`, malformed lines are skipped
+ *        and each goes to stderr as one JSON diagnostic line.
+ */
+template <typename inf_source>
+void print_report(const inf_source& inf, const std::filesystem::path& inf_path, const options& settings)
+{
+    report inf_report;
+    if (settings.lenient)
+    {
+        std::vector<line_diagnostic> diagnostics;
+        inf_report = value_or_throw(try_select_report_data(inf, diagnostics));
+        for (const parse_diagnostic& diagnostic : to_parse_diagnostics(diagnostics))
+        {
+            std::cerr << nlohmann::json(diagnostic).dump() << '\n';
+        }
+    }
+    else
+    {
+        inf_report = select_report_data(inf);
+    }
+    if (settings.manifest)
+    {
+        task_pool pool;
+        content_hash_cache hashes;
+
+        nlohmann::json output;
+        output["manufacturers"] = inf_report;
+        output["payload"] = build_payload_manifest(inf, inf_path, pool, hashes);
+        std::cout << output.dump(2) << std::endl;
+    }
+    else
+    {
+        std::cout << nlohmann::json(inf_report).dump(2) << std::endl;
+    }
+}
+
+/**
+ * @brief Single-INF mode. The INF is checked against the parse limits
+ *        first. With a snapshot cache it is read through its `.infc`
+ *        snapshot, which is built on first use.
+ */
+void run_report(const options& settings)
+{
+    const std::filesystem::path& inf_path = settings.inputs.front();
+
+    std::optional<sha256_digest> digest;
+    {
+        mapped_file content{ inf_path };
+        check_parse_limits(content.contents(), settings.limits);
+        if (settings.cache_directory.has_value())
+        {
+            digest = sha256(content.contents());
+        }
+    }
+
+    if (digest.has_value())
+    {
+        with_cached_inf(
+            inf_path,
+            *digest,
+            *settings.cache_directory,
+            [&](const auto& inf) { print_report(inf, inf_path, settings); });
+    }
+    else
+    {
+        print_report(inf_file{ inf_path }, inf_path, settings);
+    }
+}
+
+/**
+ * @brief Batch mode: hash and parse every INF below a directory through the
+ *        staged pipeline and stream one JSON line per INF, in walk order.
+ *        The output is a corpus index usable by `--diff`; with `--bloom` the
+ *        hardware-ID filters of the entries are written to a sidecar for
+ *        `--match`. Read queue depth and peak reorder buffering go to
+ *        stderr.
+ */
+void run_batch(const options& settings)
+{
+    const auto started = std::chrono::steady_clock::now();
+    const std::filesystem::path& root = settings.inputs.front();
+    const std::vector<inf_listing> files = list_inf_files(root);
+
+    pipeline_settings stages;
+    stages.readers = settings.reader_threads.value_or(stages.readers);
+    stages.parsers = settings.parser_threads.value_or(stages.parsers);
+    stages.read_ahead = settings.read_ahead.value_or(stages.read_ahead);
+    stages.file_timeout = settings.file_timeout;
+    stages.mode = settings.lenient ? parse_mode::lenient : parse_mode::strict;
+    stages.limits = settings.limits;
+    if (settings.deadline.has_value())
+    {
+        stages.deadline = started + *settings.deadline;
+    }
+
+    std::vector<blocked_bloom_filter> filters;
+    std::optional<index_fingerprint> index;
+    if (settings.bloom_sidecar.has_value())
+    {
+        index.emplace();
+    }
+
+    const pipeline_statistics statistics = run_batch_pipeline(
+        root,
+        files,
+        settings.cache_directory,
+        settings.bloom_sidecar.has_value(),
+        stages,
+        [&filters, &index](batch_line& line)
+        {
+            std::cout << line.json << '\n';
+
+            if (line.filter.has_value())
+            {
+                filters.push_back(std::move(*line.filter));
+                index->add(line.json);
+            }
+        });
+
+    std::cout.flush();
+
+    if (settings.bloom_sidecar.has_value())
+    {
+        write_bloom_sidecar(*settings.bloom_sidecar, filters, *index);
+    }
+
+    nlohmann::json summary;
+    summary["read_queue"] = statistics.read_queue;
+    summary["peak_buffered_bytes"] = statistics.peak_buffered_bytes;
+    summary["read_tasks"] = statistics.read_tasks;
+    summary["timeouts"] = statistics.timeouts;
+    summary["io_ring"] = statistics.io_ring;
+    std::cerr << summary.dump() << std::endl;
+}
+
+/**
+ * @brief Diff mode: stream hardware-ID and model changes between two
+ *        corpora, one JSON line per change.
+ */
+void run_diff(const options& settings)
+{
+    task_pool pool;
+    corpus before = load_corpus(settings.inputs[0], pool);
+    corpus after = load_corpus(settings.inputs[1], pool);
+
+    diff_corpora(before, after, pool, [](const diff_record& record)
+        {
+            std::cout << nlohmann::json(record).dump() << '\n';
+        });
+
+    std::cout.flush();
+}
+
+/**
+ * @brief Query mode: index the hardware IDs of a corpus and stream one JSON
+ *        line per ID matching the glob pattern, with its occurrences.
+ */
+void run_query(const options& settings)
+{
+    task_pool pool;
+    corpus entries = load_corpus(settings.inputs.front(), pool);
+    parse_corpus(entries, pool);
+
+    const hardware_id_trie index = build_hardware_id_trie(entries);
+    index.find_matching(fold_key(settings.pattern), [&entries](std::string_view, std::span<const hardware_id_posting> postings)
+        {
+            std::cout << nlohmann::json(resolve_postings(entries, postings)).dump() << '\n';
+        });
+
+    std::cout.flush();
+}
+
+/**
+ * @brief Match mode: find the entries of a `--batch` index that contain any
+ *        of the given hardware IDs, decoding only the entries its Bloom
+ *        filter sidecar (`<index>.bloom` by default) lets through. One JSON
+ *        line per occurrence goes to stdout, the filter statistics to
+ *        stderr.
+ */
+void run_match(const options& settings)
+{
+    const std::filesystem::path& index_path = settings.inputs.front();
+
+    std::filesystem::path sidecar_path = index_path;
+    sidecar_path += L".bloom";
+    const bloom_sidecar filters{ settings.bloom_sidecar.value_or(sidecar_path) };
+
+    std::ifstream index{ index_path, std::ios::binary };
+    if (!index)
+    {
+        throw std::runtime_error("Failed to open the corpus index");
+    }
+
+    if (!filters.describes(index))
+    {
+        throw std::runtime_error("The Bloom filter sidecar was not written for this index");
+    }
+
+    index.clear();
+    index.seekg(0);
+
+    const bloom_match_statistics statistics = match_corpus_index(index, filters, settings.hardware_ids, [](const index_match& match)
+        {
+            std::cout << nlohmann::json(match).dump() << '\n';
+        });
+
+    std::cout.flush();
+
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    nlohmann::json summary;
+    summary["entries"] = statistics.entries;
+    summary["candidates"] = statistics.candidates;
+    summary["matched"] = statistics.matched;
+    summary["false_positive_rate"] = statistics.false_positive_rate();
+    summary["probe_ms"] = milliseconds{ statistics.probe_time }.count();
+    summary["decode_ms"] = milliseconds{ statistics.decode_time }.count();
+    std::cerr << summary.dump() << std::endl;
+}
+
+/**
+ * @brief Rank mode: print the models of a corpus that match a device, one
+ *        JSON line each, in the order Windows would prefer them; the first
+ *        line is the driver it would select. The device runs 64-bit x86
+ *        Windows of any version unless `--platform` says otherwise.
+ */
+void run_rank(const options& settings)
+{
+    task_pool pool;
+    corpus entries = load_corpus(settings.inputs.front(), pool);
+    parse_corpus(entries, pool);
+
+    const platform_decoration platform = settings.platform.value_or(*parse_platform_decoration("NTamd64"));
+
+    const ranking_index index{ entries };
+    for (const ranked_driver& driver : index.rank(settings.hardware_ids, settings.compatible_ids, platform))
+    {
+        std::cout << nlohmann::json(index.resolve(driver)).dump() << '\n';
+    }
+
+    std::cout.flush();
+}
+
+/**
+ * @brief Inventory mode: join the devices of a fleet inventory against a
+ *        corpus and print one JSON line per machine with the coverage of each
+ *        device; join statistics go to stderr.
+ */
+void run_inventory(const options& settings)
+{
+    std::ifstream input{ settings.inventory, std::ios::binary };
+    if (!input)
+    {
+        throw std::runtime_error("Failed to open the inventory");
+    }
+
+    const inventory fleet = read_inventory(input);
+
+    task_pool pool;
+    corpus entries = load_corpus(settings.inputs.front(), pool);
+    parse_corpus(entries, pool);
+
+    const hardware_id_dictionary dictionary = build_hardware_id_dictionary(entries);
+    const inventory_join join{ fleet, entries, dictionary };
+
+    size_t devices{ 0 };
+    size_t covered{ 0 };
+    for (const inventory_machine& machine : fleet.machines)
+    {
+        const machine_coverage coverage = join.cover(machine);
+        devices += coverage.devices.size();
+        covered += coverage.covered;
+        std::cout << nlohmann::json(coverage).dump() << '\n';
+    }
+
+    std::cout.flush();
+
+    nlohmann::json summary;
+    summary["machines"] = fleet.machines.size();
+    summary["devices"] = devices;
+    summary["covered"] = covered;
+    summary["distinct_ids"] = fleet.keys.size();
+    summary["matched_ids"] = join.matched_keys();
+    summary["corpus_ids"] = dictionary.keys.size();
+    std::cerr << summary.dump() << std::endl;
+}
+
+/**
+ * @brief Plan mode: select a small set of packages of a corpus that covers
+ *        every device of an inventory and print it, with the devices no
+ *        package covers, as one JSON document.
+ */
+void run_plan(const options& settings)
+{
+    std::ifstream input{ settings.inventory, std::ios::binary };
+    if (!input)
+    {
+        throw std::runtime_error("Failed to open the inventory");
+    }
+
+    const inventory fleet = read_inventory(input);
+
+    task_pool pool;
+    corpus entries = load_corpus(settings.inputs.front(), pool);
+    parse_corpus(entries, pool);
+
+    const coverage_matrix matrix = build_coverage_matrix(fleet, build_hardware_id_dictionary(entries));
+    std::cout << nlohmann::json(plan_driver_set(matrix, entries)).dump(2) << std::endl;
+}
+
+/**
+ * @brief Cluster mode: group the near-duplicate INFs of a corpus by the
+ *        similarity of their hardware-ID sets and print one JSON line per
+ *        cluster.
+ */
+void run_cluster(const options& settings)
+{
+    static constexpr double similarity_threshold{ 0.7 };
+
+    task_pool pool;
+    corpus entries;
+    const std::vector<std::optional<minhash_signature>> signatures = sign_corpus(settings.inputs.front(), entries, pool);
+
+    for (const package_cluster& cluster : cluster_corpus(entries, signatures, similarity_threshold))
+    {
+        nlohmann::json line;
+        line["size"] = cluster.size();
+        line["members"] = cluster;
+        std::cout << line.dump() << '\n';
+    }
+
+    std::cout.flush();
+}
+
+/**
+ * @brief Dedup mode: print every unique model of a corpus once, one JSON
+ *        line each, with the INFs, manufacturers and architectures it
+ *        appears under; totals go to stderr.
+ */
+void run_dedup(const options& settings)
+{
+    task_pool pool;
+    corpus entries = load_corpus(settings.inputs.front(), pool);
+
+    size_t references{ 0 };
+    const std::vector<deduplicated_model> models = deduplicate_corpus_models(entries, pool);
+    for (const deduplicated_model& unique : models)
+    {
+        references += unique.references.size();
+        std::cout << nlohmann::json(unique).dump() << '\n';
+    }
+
+    std::cout.flush();
+
+    nlohmann::json summary;
+    summary["references"] = references;
+    summary["unique_models"] = models.size();
+    std::cerr << summary.dump() << std::endl;
+}
+
+/**
+ * @brief Triage mode: print the class, provider, driver version, catalog
+ *        and whether it has a `[Manufacturer]` section for every INF of a
+ *        directory, one JSON line each, without building any report;
+ *        totals go to stderr.
+ */
+void run_triage(const options& settings)
+{
+    task_pool pool;
+
+    size_t drivers{ 0 };
+    size_t failed{ 0 };
+    const std::vector<triage_entry> entries = triage_corpus(settings.inputs.front(), settings.limits, pool);
+    for (const triage_entry& entry : entries)
+    {
+        if (!entry.triage.has_value())
+        {
+            ++failed;
+        }
+        else if (entry.triage->has_manufacturer)
+        {
+            ++drivers;
+        }
+
+        std::cout << nlohmann::json(entry).dump() << '\n';
+    }
+
+    std::cout.flush();
+
+    nlohmann::json summary;
+    summary["infs"] = entries.size();
+    summary["drivers"] = drivers;
+    summary["failed"] = failed;
+    std::cerr << summary.dump() << std::endl;
+}
+
+/**
+ * @brief Watch mode: rebuild the report whenever the INF is written to,
+ *        reusing the manufacturers whose sections did not change, until the
+ *        process is stopped. Each report goes to stdout; rebuild statistics
+ *        and errors go to stderr and do not end the watch.
+ */
+void run_watch(const options& settings)
+{
+    static constexpr std::chrono::milliseconds poll_interval{ 500 };
+
+    const std::filesystem::path& inf_path = settings.inputs.front();
+
+    incremental_report builder;
+    std::optional<std::filesystem::file_time_type> built_from;
+    while (true)
+    {
+        std::error_code error;
+        const auto written = std::filesystem::last_write_time(inf_path, error);
+        if (!error && built_from != written)
+        {
+            built_from = written;
+            try
+            {
+                const report rebuilt = builder.rebuild(inf_path, settings.limits);
+                std::cout << nlohmann::json(rebuilt).dump(2) << std::endl;
+
+                nlohmann::json summary;
+                summary["reused"] = builder.last_statistics().reused;
+                summary["rebuilt"] = builder.last_statistics().rebuilt;
+                std::cerr << summary.dump() << std::endl;
+            }
+            catch (const std::bad_alloc&)
+            {
+                throw;
+            }
+            catch (const std::exception& e)
+            {
+                nlohmann::json failure;
+                failure["error"] = e.what();
+                std::cerr << failure.dump() << std::endl;
+            }
+        }
+
+        std::this_thread::sleep_for(poll_interval);
+    }
+}
+
 /**
  * @brief Worker entry that performs parsing and JSON emission.
  * @param argc Count of command-line arguments.
- * @param argv Wide-character argv; expects `argv[1]` to be a path to an INF.
+ * @param argv Wide-character argv; see `usage`.
  * @return Exit code as `exit_codes` enum.
  */
 exit_codes main_with_code(int argc, wchar_t* argv[])
 {
-    if (argc < 2)
+    std::optional<options> settings = parse_command_line(argc, argv);
+    if (!settings.has_value())
     {
-        std::cerr << "Usage: inf_to_json <inf-file-path>" << std::endl;
+        std::cerr << usage << std::flush;
         return exit_codes::invalid_arguments;
     }
 
     try
     {
-        inf_file file(argv[1]);
-        auto r = select_report_data(file);
-        std::cout << nlohmann::json(r).dump(2) << std::endl;
+        switch (settings->mode)
+        {
+        case command::report:
+            run_report(*settings);
+            break;
+
+        case command::batch:
+            run_batch(*settings);
+            break;
+
+        case command::diff:
+            run_diff(*settings);
+            break;
+
+        case command::watch:
+            run_watch(*settings);
+            break;
+
+        case command::query:
+            run_query(*settings);
+            break;
+
+        case command::match:
+            run_match(*settings);
+            break;
+
+        case command::rank:
+            run_rank(*settings);
+            break;
+
+        case command::inventory:
+            run_inventory(*settings);
+            break;
+
+        case command::plan:
+            run_plan(*settings);
+            break;
+
+        case command::cluster:
+            run_cluster(*settings);
+            break;
+
+        case command::dedup:
+            run_dedup(*settings);
+            break;
+
+        case command::triage:
+            run_triage(*settings);
+            break;
+        }
     }
     catch (const std::bad_alloc&)
     {
@@ -0,0 +1,450 @@
+/**
+ * @file manifest.h
+ * @brief Payload manifest: the files a driver package copies, resolved
+ *        relative to the INF and hashed with SHA-256.
+ *
+ * Sources of file names:
+ *  - `[SourceDisksFiles]` (and its platform decorations), which also gives
+ *    the disk and subdirectory a file is read from;
+ *  - `CopyFiles` directives of the install sections referenced by the models
+ *    sections, either `@file` entries or file-list sections.
+ */
+
+/**
+ * @class source_file
+ * @brief Location of one `[SourceDisksFiles]` entry:
+ *        `filename = diskid[,[subdir][,size]]`.
+ */
+class source_file
+{
+public:
+    std::wstring disk_id;
+    std::wstring subdirectory;
+};
+
+/**
+ * @typedef source_disks
+ * @brief `[SourceDisksNames]` disk ID mapped to the disk path relative to
+ *        the INF directory.
+ */
+using source_disks = std::unordered_map<key_name, std::wstring>;
+
+/**
+ * @typedef source_files
+ * @brief `[SourceDisksFiles]` file name mapped to its source location.
+ */
+using source_files = std::unordered_map<key_name, source_file>;
+
+/**
+ * @class payload_file
+ * @brief Manifest entry for one file of the package.
+ *
+ * `path` is relative to the INF directory. `size` and `sha256` are only
+ * meaningful when `present` is set.
+ */
+class payload_file
+{
+public:
+    std::string name;
+    std::string path;
+    bool present;
+    std::uint64_t size;
+    std::string sha256;
+};
+
+/**
+ * @typedef payload_manifest
+ * @brief Files of one package: copied files first, in install order, then
+ *        any remaining `[SourceDisksFiles]` entries.
+ */
+using payload_manifest = std::vector<payload_file>;
+
+/**
+ * @brief Select a section and its dot-decorated variants
+ *        (`SourceDisksFiles`, `SourceDisksFiles.amd64`, ...).
+ * @return Matching section names, sorted so that the undecorated section
+ *         comes first.
+ */
+std::vector<section_name> select_decorated_sections(
+    const std::unordered_set<section_name>& all_sections,
+    section_name_view base)
+{
+    static constexpr wchar_t delimiter = '.';
+
+    std::vector<section_name> result;
+    for (const section_name& section : all_sections)
+    {
+        if (section.size() >= base.size()
+            && section_name_view{ section }.substr(0, base.size()) == base
+            && (section.size() == base.size() || section[base.size()] == delimiter))
+        {
+            result.push_back(section);
+        }
+    }
+
+    std::ranges::sort(result);
+    return result;
+}
+
+/**
+ * @brief Parse `[SourceDisksNames]` and its decorations.
+ *
+ * Line format: `diskid = description[,[tag],[unused],[path],...]`.
+ */
+template <typename inf_source>
+source_disks extract_source_disks(
+    const inf_source& inf,
+    const std::unordered_set<section_name>& all_sections)
+{
+    static constexpr size_t path_field{ 3 };
+
+    source_disks result;
+    for (const section_name& section : select_decorated_sections(all_sections, L"SourceDisksNames"))
+    {
+        inf.for_each_line(section, [&result](auto&& line)
+            {
+                std::wstring path;
+                if (line.size() > path_field)
+                {
+                    path = line.field_at(path_field);
+                }
+
+                result.try_emplace(key_name{ line.key() }, std::move(path));
+                return enumeration::move_next;
+            });
+    }
+
+    return result;
+}
+
+/**
+ * @brief Parse `[SourceDisksFiles]` and its decorations.
+ *
+ * Line format: `filename = diskid[,[subdir][,size]]`.
+ */
+template <typename inf_source>
+source_files extract_source_files(
+    const inf_source& inf,
+    const std::unordered_set<section_name>& all_sections)
+{
+    source_files result;
+    for (const section_name& section : select_decorated_sections(all_sections, L"SourceDisksFiles"))
+    {
+        inf.for_each_line(section, [&result](auto&& line)
+            {
+                source_file file;
+                if (line.size() > 0)
+                {
+                    file.disk_id = line.field_at(0);
+                }
+
+                if (line.size() > 1)
+                {
+                    file.subdirectory = line.field_at(1);
+                }
+
+                result.try_emplace(key_name{ line.key() }, std::move(file));
+                return enumeration::move_next;
+            });
+    }
+
+    return result;
+}
+
+/**
+ * @brief Resolve the DDInstall section Windows would use for a model.
+ *
+ * Tries the platform decoration taken from the models-section architecture
+ * (`install.NTamd64` for `NTamd64.10.0...16299`), then `install.NT`, then
+ * the undecorated name.
+ */
+std::optional<section_name> resolve_install_section(
+    section_name_view install_section,
+    std::wstring_view architecture,
+    const std::unordered_set<section_name>& all_sections)
+{
+    static constexpr wchar_t delimiter = '.';
+
+    std::wstring_view platform = architecture.substr(0, architecture.find(delimiter));
+
+    std::vector<section_name> candidates;
+    for (std::wstring_view decoration : { platform, std::wstring_view{ L"NT" } })
+    {
+        if (!decoration.empty())
+        {
+            section_name composed{ install_section };
+            composed += delimiter;
+            composed.append_range(decoration);
+            candidates.push_back(std::move(composed));
+        }
+    }
+
+    candidates.emplace_back(install_section);
+
+    for (const section_name& candidate : candidates)
+    {
+        if (auto found = all_sections.find(candidate)
+            ; found != all_sections.end())
+        {
+            return *found;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * @brief Collect the source names of all files copied by the install
+ *        sections of the models, in first-seen order without duplicates.
+ *
+ * `CopyFiles` values are either `@file` (a single file) or the name of a
+ * file-list section whose lines are `destination[,source[,...]]`; the source
+ * name wins when present.
+ */
+template <typename inf_source>
+std::vector<key_name> extract_copied_files(
+    const inf_source& inf,
+    const std::unordered_set<section_name>& all_sections)
+{
+    static constexpr wchar_t single_file_prefix = '@';
+
+    std::vector<section_name> install_sections;
+    {
+        std::unordered_set<section_name> seen;
+        for (const auto& inf_manufacturer : extract_manufacturers(inf))
+        {
+            for (models_sections_correlation correlation : correlate_models_sections(inf_manufacturer, all_sections))
+            {
+                for (const auto& inf_device : extract_device_descriptions(inf, correlation.models_section))
+                {
+                    std::optional<section_name> install = resolve_install_section(
+                        inf_device.install_section,
+                        correlation.architecture,
+                        all_sections);
+
+                    if (install.has_value() && seen.insert(*install).second)
+                    {
+                        install_sections.push_back(std::move(*install));
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<key_name> result;
+    std::unordered_set<key_name> seen;
+    auto add = [&result, &seen](std::wstring_view name)
+        {
+            if (!name.empty() && seen.emplace(std::from_range, name).second)
+            {
+                result.emplace_back(std::from_range, name);
+            }
+        };
+
+    for (const section_name& install_section : install_sections)
+    {
+        std::vector<std::wstring> directives;
+        inf.for_each_line(install_section, [&directives](auto&& line)
+            {
+                if (line.key() == L"CopyFiles")
+                {
+                    for (size_t i = 0; i < line.size(); ++i)
+                    {
+                        directives.emplace_back(line.field_at(i));
+                    }
+                }
+
+                return enumeration::move_next;
+            });
+
+        for (const std::wstring& directive : directives)
+        {
+            if (directive.starts_with(single_file_prefix))
+            {
+                add(std::wstring_view{ directive }.substr(1));
+                continue;
+            }
+
+            section_name list_name{ std::from_range, directive };
+            if (!all_sections.contains(list_name))
+            {
+                continue;
+            }
+
+            inf.for_each_line(list_name, [&add](auto&& line)
+                {
+                    if (line.size() > 1 && !line.field_at(1).empty())
+                    {
+                        add(line.field_at(1));
+                    }
+                    else if (line.size() > 0)
+                    {
+                        add(line.field_at(0));
+                    }
+
+                    return enumeration::move_next;
+                });
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @class content_hash_cache
+ * @brief Run-wide SHA-256 cache keyed by physical file identity.
+ *
+ * The same payload file is often reachable from many INFs (or through
+ * several paths); each physical file is mapped and hashed once, on the
+ * pool, and every requester shares the resulting future.
+ */
+class content_hash_cache
+{
+private:
+    std::mutex lock;
+    std::unordered_map<file_identity, std::shared_future<sha256_digest>> digests;
+
+public:
+    /**
+     * @brief Schedule hashing of a file unless it was already scheduled.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    std::shared_future<sha256_digest> request(task_pool& pool, const std::filesystem::path& path)
+    {
+        const file_identity identity = identify_file(path);
+
+        std::lock_guard guard{ lock };
+        if (auto found = digests.find(identity)
+            ; found != digests.end())
+        {
+            return found->second;
+        }
+
+        std::shared_future<sha256_digest> digest = pool.async([path]
+            {
+                mapped_file file{ path };
+                return sha256(file.contents());
+            }).share();
+
+        digests.emplace(identity, digest);
+        return digest;
+    }
+};
+
+/**
+ * @brief Strip leading separators so that an INF-relative path such as
+ *        `\amd64` is not treated as rooted when joined.
+ */
+std::filesystem::path relative_component(std::wstring_view value)
+{
+    size_t first = value.find_first_not_of(L"\\/");
+    return first == std::wstring_view::npos
+        ? std::filesystem::path{}
+        : std::filesystem::path{ value.substr(first) };
+}
+
+/**
+ * @brief Test whether a normalized INF-relative path stays inside the
+ *        package directory: no drive, no root and no leading `..`.
+ */
+bool is_inside_package(const std::filesystem::path& relative)
+{
+    return !relative.has_root_name()
+        && !relative.has_root_directory()
+        && (relative.empty() || *relative.begin() != L"..");
+}
+
+/**
+ * @brief Build the payload manifest of an INF and hash every file present
+ *        next to it.
+ *
+ * Paths come from untrusted INFs; a file whose path leaves the package
+ * directory is reported missing and never opened.
+ *
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
+ * @param inf_path Path the INF was opened from; files are resolved
+ *        relative to its directory.
+ * @param pool Pool running the hashing tasks.
+ * @param hashes Run-wide cache so shared files are hashed once.
+ * @throws std::exception on Win32, parsing or hashing failures.
+ */
+template <typename inf_source>
+payload_manifest build_payload_manifest(
+    const inf_source& inf,
+    const std::filesystem::path& inf_path,
+    task_pool& pool,
+    content_hash_cache& hashes)
+{
+    const std::unordered_set<section_name> all_sections = extract_sections(inf);
+    const source_disks disks = extract_source_disks(inf, all_sections);
+    const source_files files = extract_source_files(inf, all_sections);
+
+    std::vector<key_name> names = extract_copied_files(inf, all_sections);
+    {
+        std::unordered_set<key_name> listed{ std::from_range, names };
+        std::vector<key_name> remaining;
+        for (const auto& [name, location] : files)
+        {
+            if (!listed.contains(name))
+            {
+                remaining.push_back(name);
+            }
+        }
+
+        std::ranges::sort(remaining);
+        names.append_range(std::move(remaining));
+    }
+
+    const std::filesystem::path root = inf_path.parent_path();
+
+    payload_manifest manifest;
+    std::vector<std::optional<std::shared_future<sha256_digest>>> digests;
+    manifest.reserve(names.size());
+    digests.reserve(names.size());
+
+    for (const key_name& name : names)
+    {
+        std::filesystem::path relative;
+        if (auto file = files.find(name)
+            ; file != files.end())
+        {
+            if (auto disk = disks.find(key_name{ std::from_range, file->second.disk_id })
+                ; disk != disks.end())
+            {
+                relative /= relative_component(disk->second);
+            }
+
+            relative /= relative_component(file->second.subdirectory);
+        }
+
+        relative /= relative_component(std::wstring_view{ name.data(), name.size() });
+        relative = relative.lexically_normal();
+
+        const std::filesystem::path full_path = root / relative;
+
+        std::error_code error;
+        const bool present = is_inside_package(relative) && std::filesystem::is_regular_file(full_path, error);
+        const std::uint64_t size = present ? std::filesystem::file_size(full_path, error) : 0;
+
+        manifest.push_back(payload_file{
+            .name = to_utf8(name),
+            .path = to_utf8(relative.native()),
+            .present = present,
+            .size = error ? 0 : size,
+            .sha256 = {} });
+
+        digests.push_back(present
+            ? std::optional{ hashes.request(pool, full_path) }
+            : std::nullopt);
+    }
+
+    for (size_t i = 0; i < manifest.size(); ++i)
+    {
+        if (digests[i].has_value())
+        {
+            manifest[i].sha256 = to_hex(digests[i]->get());
+        }
+    }
+
+    return manifest;
+}
@@ -0,0 +1,633 @@
+/**
+ * @file parallel.h
+ * @brief Small concurrency building blocks shared by the multi-file features.
+ */
+
+/**
+ * @class task_pool
+ * @brief Fixed set of `std::jthread` workers draining a FIFO of type-erased
+ *        tasks.
+ *
+ * Tasks submitted through `submit` must not throw; use `async` to route a
+ * result or an exception back to the caller through a `std::future`.
+ * Destruction finishes the queued tasks, then joins the workers.
+ */
+class task_pool
+{
+private:
+    std::mutex lock;
+    std::condition_variable_any available;
+    std::deque<std::move_only_function<void()>> pending;
+    std::vector<std::jthread> workers; // declared last: joined before the queue is destroyed
+
+    void run(std::stop_token stop)
+    {
+        while (true)
+        {
+            std::move_only_function<void()> task;
+            {
+                std::unique_lock guard{ lock };
+                if (!available.wait(guard, stop, [this] { return !pending.empty(); }))
+                {
+                    return;
+                }
+
+                task = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            task();
+        }
+    }
+
+public:
+    static std::size_t default_concurrency() noexcept
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    explicit task_pool(std::size_t concurrency = default_concurrency())
+    {
+        workers.reserve(concurrency);
+        for (std::size_t i = 0; i < concurrency; ++i)
+        {
+            workers.emplace_back([this](std::stop_token stop) { run(stop); });
+        }
+    }
+
+    task_pool(task_pool&) = delete;
+    task_pool& operator=(task_pool&) = delete;
+
+    std::size_t concurrency() const noexcept
+    {
+        return workers.size();
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<void, F&>
+    void submit(F&& task)
+    {
+        {
+            std::lock_guard guard{ lock };
+            pending.emplace_back(std::forward<F>(task));
+        }
+
+        available.notify_one();
+    }
+
+    template <typename F>
+    requires std::is_invocable_v<F&>
+    std::future<std::invoke_result_t<F&>> async(F&& function)
+    {
+        std::packaged_task<std::invoke_result_t<F&>()> task{ std::forward<F>(function) };
+        std::future<std::invoke_result_t<F&>> result = task.get_future();
+        submit(std::move(task));
+        return result;
+    }
+};
+
+/**
+ * @class sharded_map
+ * @brief Hash map split into independently locked shards so that concurrent
+ *        writers rarely contend.
+ *
+ * The shard is chosen from the top bits of a Fibonacci-scrambled hash, so
+ * it is independent of the low bits `std::unordered_map` buckets on. Shards
+ * are cache-line aligned so that their locks do not share a line.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class sharded_map
+{
+private:
+    static constexpr size_t shard_bits{ 6 };
+
+    class alignas(64) shard
+    {
+    public:
+        std::mutex lock;
+        std::unordered_map<K, V, Hash> items;
+    };
+
+    std::array<shard, size_t{ 1 } << shard_bits> shards;
+
+    shard& shard_of(size_t hash) noexcept
+    {
+        return shards[(static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> (64 - shard_bits)];
+    }
+
+public:
+    /**
+     * @brief Insert `key` with a value-initialized value if it is missing,
+     *        then call `update` on its value under the shard lock.
+     */
+    template <typename F>
+    requires std::is_invocable_v<F&, V&, bool>
+    void upsert(K key, F&& update)
+    {
+        shard& target = shard_of(Hash{}(key));
+
+        std::lock_guard guard{ target.lock };
+        auto [position, inserted] = target.items.try_emplace(std::move(key));
+        update(position->second, inserted);
+    }
+
+    /**
+     * @brief Move every value out of the map. Not safe against concurrent
+     *        writers.
+     */
+    std::vector<V> drain()
+    {
+        std::vector<V> result;
+        for (shard& item : shards)
+        {
+            for (auto& [key, value] : item.items)
+            {
+                result.push_back(std::move(value));
+            }
+
+            item.items.clear();
+        }
+
+        return result;
+    }
+};
+
+/**
+ * @class reorder_buffer
+ * @brief Hands results computed out of order to one consumer in ordinal
+ *        order, with bounded buffering.
+ *
+ * Work on ordinal `n` may only start once `n` is within `window` of the
+ * next ordinal to consume and the buffered results fit in the byte budget,
+ * so one slow item cannot make finished results pile up; storing a result
+ * never waits. The head ordinal is always allowed to start, which
+ * guarantees progress as long as whoever waits in `acquire` does not hold
+ * back the head. Buffered bytes can exceed the budget by the results that
+ * were already in flight.
+ */
+template <typename T>
+class reorder_buffer
+{
+private:
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<std::optional<T>> slots;
+    std::vector<size_t> slot_bytes;
+    size_t head{ 0 };
+    size_t byte_budget;
+    size_t buffered_bytes{ 0 };
+    size_t peak_bytes{ 0 };
+    bool abandoned{ false };
+    std::exception_ptr failure;
+
+public:
+    reorder_buffer(size_t window, size_t byte_budget)
+        : slots(std::max<size_t>(window, 1)),
+        slot_bytes(slots.size(), 0),
+        byte_budget{ byte_budget }
+    {
+    }
+
+    /**
+     * @brief Wait until work on `ordinal` may start: it is the head, or it
+     *        is within the window and the buffer is within its budget.
+     * @return `false` if the buffer was abandoned and the work should be
+     *         skipped.
+     */
+    bool acquire(size_t ordinal)
+    {
+        std::unique_lock guard{ lock };
+        changed.wait(guard, [&]
+            {
+                return abandoned || ordinal == head || (ordinal < head + slots.size() && buffered_bytes <= byte_budget);
+            });
+        return !abandoned;
+    }
+
+    /**
+     * @brief Non-waiting `acquire`, for producers that must keep serving
+     *        other work (such as pending I/O) instead of blocking.
+     * @return `true` if work on `ordinal` may start now.
+     */
+    bool try_acquire(size_t ordinal)
+    {
+        std::lock_guard guard{ lock };
+        return !abandoned && (ordinal == head || (ordinal < head + slots.size() && buffered_bytes <= byte_budget));
+    }
+
+    /**
+     * @brief Test whether the consumer gave up.
+     */
+    bool is_abandoned()
+    {
+        std::lock_guard guard{ lock };
+        return abandoned;
+    }
+
+    /**
+     * @brief Store the result of an acquired ordinal.
+     */
+    void push(size_t ordinal, T value, size_t bytes)
+    {
+        std::lock_guard guard{ lock };
+        if (abandoned)
+        {
+            return;
+        }
+
+        const size_t slot = ordinal % slots.size();
+        slots[slot] = std::move(value);
+        slot_bytes[slot] = bytes;
+        buffered_bytes += bytes;
+        peak_bytes = std::max(peak_bytes, buffered_bytes);
+        changed.notify_all();
+    }
+
+    /**
+     * @brief Wait for the head result and take it.
+     * @throws The failure a producer abandoned the buffer with.
+     */
+    T pop()
+    {
+        std::unique_lock guard{ lock };
+
+        const size_t slot = head % slots.size();
+        changed.wait(guard, [&] { return slots[slot].has_value() || failure; });
+        if (!slots[slot].has_value())
+        {
+            std::rethrow_exception(failure);
+        }
+
+        T result = std::move(*slots[slot]);
+        slots[slot].reset();
+        buffered_bytes -= slot_bytes[slot];
+        ++head;
+        changed.notify_all();
+        return result;
+    }
+
+    /**
+     * @brief Release every waiting producer and drop further results; used
+     *        when the consumer stops early, or by a producer that cannot
+     *        deliver, with the `reason` the consumer will get from `pop`.
+     */
+    void abandon(std::exception_ptr reason = nullptr)
+    {
+        std::lock_guard guard{ lock };
+        abandoned = true;
+        if (reason && !failure)
+        {
+            failure = reason;
+        }
+
+        changed.notify_all();
+    }
+
+    size_t peak_buffered_bytes()
+    {
+        std::lock_guard guard{ lock };
+        return peak_bytes;
+    }
+};
+
+/**
+ * @brief Wait step for lock-free polling: yield for a while, then sleep, so
+ *        that an idle stage of an I/O-bound scan does not burn a core.
+ */
+inline void backoff(unsigned& attempt)
+{
+    static constexpr unsigned yield_attempts{ 64 };
+    static constexpr std::chrono::microseconds sleep_interval{ 100 };
+
+    if (attempt < yield_attempts)
+    {
+        std::this_thread::yield();
+        ++attempt;
+    }
+    else
+    {
+        std::this_thread::sleep_for(sleep_interval);
+    }
+}
+
+/**
+ * @class queue_statistics
+ * @brief Depth and contention counters of a `bounded_queue`.
+ */
+class queue_statistics
+{
+public:
+    size_t capacity;
+    size_t pushes;
+    size_t peak_depth;
+    double mean_depth;
+    size_t full_waits;
+    size_t empty_waits;
+};
+
+/**
+ * @class bounded_queue
+ * @brief Lock-free bounded multi-producer, multi-consumer FIFO (Dmitry
+ *        Vyukov's design): a power-of-two ring whose cells carry a sequence
+ *        number telling producers and consumers whose turn it is.
+ *
+ * `push` and `pop` poll with `backoff` when the queue is full or empty.
+ * After `close`, `pop` drains what is left and then returns
+ * `std::nullopt`.
+ */
+template <typename T>
+class bounded_queue
+{
+private:
+    class cell
+    {
+    public:
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    std::unique_ptr<cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_position{ 0 };
+    alignas(64) std::atomic<size_t> dequeue_position{ 0 };
+    alignas(64) std::atomic<bool> closed{ false };
+    std::atomic<size_t> push_count{ 0 };
+    std::atomic<size_t> depth_sum{ 0 };
+    std::atomic<size_t> peak_depth{ 0 };
+    std::atomic<size_t> full_waits{ 0 };
+    std::atomic<size_t> empty_waits{ 0 };
+
+    void record_depth(size_t position) noexcept
+    {
+        const size_t depth = position + 1 - std::min(position + 1, dequeue_position.load(std::memory_order_relaxed));
+        push_count.fetch_add(1, std::memory_order_relaxed);
+        depth_sum.fetch_add(depth, std::memory_order_relaxed);
+
+        size_t peak = peak_depth.load(std::memory_order_relaxed);
+        while (depth > peak && !peak_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+public:
+    /**
+     * @param capacity Minimum capacity, rounded up to a power of two.
+     */
+    explicit bounded_queue(size_t capacity)
+        : cells{ std::make_unique<cell[]>(std::bit_ceil(std::max<size_t>(capacity, 2))) },
+        mask{ std::bit_ceil(std::max<size_t>(capacity, 2)) - 1 }
+    {
+        for (size_t i = 0; i <= mask; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Append without waiting.
+     * @return `false` if the queue is full; `value` is left untouched.
+     */
+    bool try_push(T& value)
+    {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        cell* target;
+        while (true)
+        {
+            target = &cells[position & mask];
+            const size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        target->value = std::move(value);
+        target->sequence.store(position + 1, std::memory_order_release);
+        record_depth(position);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item without waiting.
+     */
+    std::optional<T> try_pop()
+    {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        cell* source;
+        while (true)
+        {
+            source = &cells[position & mask];
+            const size_t sequence = source->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return std::nullopt;
+            }
+            else
+            {
+                position = dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::optional<T> result = std::move(source->value);
+        source->value.reset();
+        source->sequence.store(position + mask + 1, std::memory_order_release);
+        return result;
+    }
+
+    /**
+     * @brief Append, waiting while the queue is full.
+     */
+    void push(T value)
+    {
+        unsigned attempt{ 0 };
+        while (!try_push(value))
+        {
+            if (attempt == 0)
+            {
+                full_waits.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            backoff(attempt);
+        }
+    }
+
+    /**
+     * @brief Take the oldest item, waiting while the queue is empty.
+     * @return `std::nullopt` once the queue is closed and drained.
+     */
+    std::optional<T> pop()
+    {
+        unsigned attempt{ 0 };
+        while (true)
+        {
+            if (std::optional<T> result = try_pop())
+            {
+                return result;
+            }
+
+            // every push happens before `close`, so one more attempt after
+            // seeing it cannot miss an item
+            if (closed.load(std::memory_order_acquire))
+            {
+                return try_pop();
+            }
+
+            if (attempt == 0)
+            {
+                empty_waits.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            backoff(attempt);
+        }
+    }
+
+    /**
+     * @brief Signal that no more items will be pushed.
+     */
+    void close() noexcept
+    {
+        closed.store(true, std::memory_order_release);
+    }
+
+    queue_statistics statistics() const noexcept
+    {
+        const size_t pushes = push_count.load(std::memory_order_relaxed);
+        return queue_statistics{
+            .capacity = mask + 1,
+            .pushes = pushes,
+            .peak_depth = peak_depth.load(std::memory_order_relaxed),
+            .mean_depth = pushes == 0 ? 0.0 : static_cast<double>(depth_sum.load(std::memory_order_relaxed)) / pushes,
+            .full_waits = full_waits.load(std::memory_order_relaxed),
+            .empty_waits = empty_waits.load(std::memory_order_relaxed) };
+    }
+};
+
+/**
+ * @class deadline_watchdog
+ * @brief One thread that signals stop tokens once their deadline passes.
+ *
+ * A `watch` arms a fresh `std::stop_source` for as long as it lives; the
+ * watched work polls its token. The thread sleeps until the earliest armed
+ * deadline, so work that finishes in time never hears from it.
+ */
+class deadline_watchdog
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    class watch
+    {
+    private:
+        deadline_watchdog& owner;
+        std::uint64_t id;
+        std::stop_token stop;
+
+    public:
+        watch(deadline_watchdog& owner, clock::time_point deadline)
+            : owner{ owner }
+        {
+            std::stop_source source;
+            stop = source.get_token();
+            {
+                std::lock_guard guard{ owner.lock };
+                id = owner.next_id++;
+                owner.armed.emplace(id, armed_deadline{ .deadline = deadline, .source = std::move(source) });
+                ++owner.generation;
+            }
+
+            owner.changed.notify_one();
+        }
+
+        ~watch()
+        {
+            // the thread may still wake for this deadline; it then finds
+            // nothing to signal
+            std::lock_guard guard{ owner.lock };
+            owner.armed.erase(id);
+        }
+
+        watch(watch&) = delete;
+        watch& operator=(watch&) = delete;
+
+        std::stop_token token() const noexcept
+        {
+            return stop;
+        }
+    };
+
+private:
+    class armed_deadline
+    {
+    public:
+        clock::time_point deadline;
+        std::stop_source source;
+    };
+
+    std::mutex lock;
+    std::condition_variable_any changed;
+    std::unordered_map<std::uint64_t, armed_deadline> armed;
+    std::uint64_t next_id{ 0 };
+    std::uint64_t generation{ 0 };
+    std::jthread thread; // declared last: joined before the watches are destroyed
+
+    void run(std::stop_token stop)
+    {
+        std::unique_lock guard{ lock };
+        while (!stop.stop_requested())
+        {
+            const clock::time_point now = clock::now();
+            std::optional<clock::time_point> next;
+            for (auto& [id, item] : armed)
+            {
+                if (item.deadline <= now)
+                {
+                    item.source.request_stop();
+                }
+                else if (!next.has_value() || item.deadline < *next)
+                {
+                    next = item.deadline;
+                }
+            }
+
+            const std::uint64_t seen = generation;
+            auto rearmed = [this, seen] { return generation != seen; };
+            if (next.has_value())
+            {
+                changed.wait_until(guard, stop, *next, rearmed);
+            }
+            else
+            {
+                changed.wait(guard, stop, rearmed);
+            }
+        }
+    }
+
+public:
+    deadline_watchdog()
+        : thread{ [this](std::stop_token stop) { run(stop); } }
+    {
+    }
+
+    deadline_watchdog(deadline_watchdog&) = delete;
+    deadline_watchdog& operator=(deadline_watchdog&) = delete;
+};
@@ -0,0 +1,181 @@
+/**
+ * @file parse_limits.h
+ * @brief Hard resource limits for untrusted INFs, checked on the raw bytes
+ *        before SetupAPI sees them.
+ *
+ * The reader and report stages are linear in the size of what SetupAPI
+ * returns. Each section is enumerated once per manufacturer that uses it,
+ * each field is read once, and models are grouped through hash maps.
+ * SetupAPI's own work is not under this tool's control. One logical line
+ * can be made arbitrarily long with `\` continuations, and every
+ * `%strkey%` token can expand to a long `[Strings]` value. So one linear
+ * pre-scan of the file bounds what SetupAPI is given:
+ *
+ *  - the file size;
+ *  - the length of every logical line, continuations joined;
+ *  - the fields of a line (commas outside quotes and comments, plus one),
+ *    which also bounds the decorations of a `[Manufacturer]` line;
+ *  - the `%strkey%` tokens of a line, which with SetupAPI's 4096-character
+ *    string limit bounds the expanded size of the line.
+ *
+ * A file over any limit fails with `limit_exceeded` without being parsed.
+ */
+
+/**
+ * @class parse_limits
+ * @brief Caps applied to an INF before parsing. The defaults are far above
+ *        anything found in real driver packages.
+ */
+class parse_limits
+{
+public:
+    std::uint64_t max_file_size{ 64 * 1024 * 1024 };
+    size_t max_line_length{ 64 * 1024 };
+    size_t max_fields{ 4096 };
+    size_t max_substitutions{ 1024 };
+};
+
+/**
+ * @class limit_exceeded
+ * @brief Thrown when an INF goes over a `parse_limits` cap.
+ */
+class limit_exceeded : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Check raw INF text against the line limits in one pass.
+ *
+ * Comments (`;` outside quotes) still count towards the line length but
+ * not towards fields or tokens. A line whose last non-blank character
+ * outside a comment is `\` continues on the next one.
+ *
+ * @tparam char_type `char` for ANSI/UTF-8 files, `wchar_t` for UTF-16LE.
+ * @throws limit_exceeded naming the limit and the 1-based line.
+ */
+template <typename char_type>
+void check_parse_limits(std::span<const char_type> text, const parse_limits& limits)
+{
+    static constexpr char_type line_feed = '\n';
+    static constexpr char_type carriage_return = '\r';
+
+    auto exceeded = [](std::string_view limit, size_t line_number)
+        {
+            throw limit_exceeded(std::format("INF line {} exceeds the {} limit", line_number, limit));
+        };
+
+    size_t line_number{ 1 };
+    size_t logical_line{ 1 };
+    size_t length{ 0 };
+    size_t fields{ 1 };
+    size_t percents{ 0 };
+    bool quoted{ false };
+    bool comment{ false };
+    char_type last{ ' ' };
+
+    for (const char_type c : text)
+    {
+        if (c == line_feed)
+        {
+            if (comment || last != char_type{ '\\' })
+            {
+                length = 0;
+                fields = 1;
+                percents = 0;
+                logical_line = line_number + 1;
+            }
+
+            ++line_number;
+            quoted = false;
+            comment = false;
+            last = ' ';
+            continue;
+        }
+
+        if (c == carriage_return)
+        {
+            continue;
+        }
+
+        if (++length > limits.max_line_length)
+        {
+            exceeded("line length", logical_line);
+        }
+
+        if (comment)
+        {
+            continue;
+        }
+
+        if (c == char_type{ '"' })
+        {
+            quoted = !quoted;
+        }
+        else if (c == char_type{ ';' } && !quoted)
+        {
+            comment = true;
+            continue;
+        }
+        else if (c == char_type{ ',' } && !quoted && ++fields > limits.max_fields)
+        {
+            exceeded("fields per line", logical_line);
+        }
+        else if (c == char_type{ '%' } && ++percents / 2 > limits.max_substitutions)
+        {
+            exceeded("string substitution", logical_line);
+        }
+
+        if (c != char_type{ ' ' } && c != char_type{ '\t' })
+        {
+            last = c;
+        }
+    }
+}
+
+/**
+ * @brief Pass the text of a mapped INF to `visit`: as a
+ *        `std::span<const wchar_t>` after a UTF-16LE byte order mark,
+ *        otherwise as a `std::span<const char>` without any UTF-8 byte order
+ *        mark.
+ * @return What `visit` returns; both calls must return the same type.
+ */
+template <typename F>
+decltype(auto) visit_inf_text(std::span<const std::byte> content, F&& visit)
+{
+    static constexpr std::byte utf16_bom[]{ std::byte{ 0xFF }, std::byte{ 0xFE } };
+    static constexpr std::byte utf8_bom[]{ std::byte{ 0xEF }, std::byte{ 0xBB }, std::byte{ 0xBF } };
+
+    if (std::ranges::starts_with(content, utf16_bom))
+    {
+        content = content.subspan(std::size(utf16_bom));
+        return visit(std::span<const wchar_t>{
+            reinterpret_cast<const wchar_t*>(content.data()),
+            content.size() / sizeof(wchar_t) });
+    }
+
+    if (std::ranges::starts_with(content, utf8_bom))
+    {
+        content = content.subspan(std::size(utf8_bom));
+    }
+
+    return visit(std::span<const char>{
+        reinterpret_cast<const char*>(content.data()),
+        content.size() });
+}
+
+/**
+ * @brief Check a mapped INF against the limits, detecting UTF-16LE and
+ *        UTF-8 byte order marks.
+ * @throws limit_exceeded if the file or one of its lines is over a limit.
+ */
+void check_parse_limits(std::span<const std::byte> content, const parse_limits& limits)
+{
+    if (content.size() > limits.max_file_size)
+    {
+        throw limit_exceeded("INF exceeds the file size limit");
+    }
+
+    visit_inf_text(content, [&limits](auto text) { check_parse_limits(text, limits); });
+}
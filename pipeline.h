@@ -0,0 +1,535 @@
+/**
+ * @file pipeline.h
+ * @brief Staged batch pipeline: readers, parse workers and one serializer.
+ *
+ * - Reader threads take files from a `batch_schedule` and read and hash
+ *   each INF. Hashing reads the whole file, so it also serves as
+ *   read-ahead: SetupAPI later parses from the page cache. Where I/O rings
+ *   are available each reader keeps `ring_depth` reads in flight through
+ *   an `io_ring_reader` into registered buffers; otherwise, or for files
+ *   larger than a buffer, it maps files one at a time. This stage is the
+ *   one to widen on network shares.
+ * - Parse workers build the report (through the snapshot cache when one is
+ *   set), the JSON line and the Bloom filter. This stage is the one to
+ *   widen on local SSDs.
+ * - The calling thread is the single serializer and writes results in walk
+ *   order.
+ *
+ * Readers and parse workers are connected by a lock-free `bounded_queue`
+ * whose capacity is the read-ahead depth. Parse results go through a
+ * `reorder_buffer`; readers wait on it before starting a file, so parse
+ * workers never block on output.
+ */
+
+/**
+ * @class pipeline_settings
+ * @brief Concurrency of each stage, time limits, parse mode and parse
+ *        limits of a run.
+ *
+ * With `parse_mode::lenient`, malformed lines are skipped and listed in
+ * the index line instead of failing the INF.
+ *
+ * A parse that outlives `file_timeout` is abandoned at the next section or
+ * line it reads and its INF gets a timeout record. `SetupOpenInfFileW`
+ * cannot be interrupted, so the timeout does not free a worker that is
+ * still opening the INF. Past `deadline`, files are neither read
+ * nor parsed any more and all get timeout records, so the index still
+ * lists every INF.
+ */
+class pipeline_settings
+{
+public:
+    size_t readers{ 2 };
+    size_t parsers{ task_pool::default_concurrency() };
+    size_t read_ahead{ 32 };
+    std::uint32_t ring_depth{ 64 };
+    std::uint32_t ring_buffer_size{ 256 * 1024 };
+    std::optional<std::chrono::steady_clock::duration> file_timeout;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    parse_mode mode{ parse_mode::strict };
+    parse_limits limits;
+};
+
+/**
+ * @class read_item
+ * @brief A hashed, unparsed entry on its way from a reader to a parse
+ *        worker.
+ */
+class read_item
+{
+public:
+    size_t ordinal;
+    corpus_entry entry;
+    std::optional<sha256_digest> digest;
+    std::exception_ptr failure;
+};
+
+/**
+ * @class batch_line
+ * @brief Output of one batch INF, serialized on a parse worker: its index
+ *        line and, with `--bloom`, its filter, or the failure to rethrow.
+ */
+class batch_line
+{
+public:
+    std::string json;
+    std::optional<blocked_bloom_filter> filter;
+    std::exception_ptr failure;
+
+    size_t bytes() const noexcept
+    {
+        return json.size() + (filter.has_value() ? filter->contents().size_bytes() : 0);
+    }
+};
+
+/**
+ * @class pipeline_statistics
+ * @brief Read queue depth, peak reorder buffering, number of reader tasks
+ *        and of timed-out INFs of a run, and whether I/O rings were
+ *        available to the readers.
+ */
+class pipeline_statistics
+{
+public:
+    queue_statistics read_queue;
+    size_t peak_buffered_bytes;
+    size_t read_tasks;
+    size_t timeouts;
+    bool io_ring;
+};
+
+/**
+ * @class batch_schedule
+ * @brief Hands batch files out to readers: large files first, small files
+ *        in groups, within what the reorder window lets start.
+ *
+ * Among the files not handed out yet in the look-ahead, one of at least
+ * 1 MiB is taken first, largest first, so that the longest parses start
+ * early instead of stretching the end of the scan. Otherwise the lowest
+ * pending files are handed out together, up to 256 KiB or 32 files, which
+ * saves a trip through the scheduler per stub INF.
+ *
+ * Every ordinal handed out has already been acquired from the reorder
+ * buffer without waiting. When none can be, a reader that may wait gets
+ * the lowest pending ordinal and waits for it: all lower ordinals are then
+ * already being read, so the head is never left unassigned.
+ */
+class batch_schedule
+{
+private:
+    static constexpr std::uint64_t large_file_size{ 1024 * 1024 };
+    static constexpr std::uint64_t group_size{ 256 * 1024 };
+
+    std::mutex lock;
+    std::span<const inf_listing> files;
+    size_t look_ahead;
+    std::vector<bool> dispatched;
+    size_t first_pending{ 0 };
+    size_t task_count{ 0 };
+
+    void mark(size_t ordinal)
+    {
+        dispatched[ordinal] = true;
+        while (first_pending < files.size() && dispatched[first_pending])
+        {
+            ++first_pending;
+        }
+    }
+
+public:
+    static constexpr size_t group_files{ 32 };
+
+    batch_schedule(std::span<const inf_listing> files, size_t look_ahead)
+        : files{ files },
+        look_ahead{ std::max<size_t>(look_ahead, 1) },
+        dispatched(files.size(), false)
+    {
+    }
+
+    /**
+     * @param may_wait Whether the caller can wait for the reorder window.
+     * @param max_files Most files the caller can take at once.
+     * @return Ordinals to read, in that order; empty when nothing can start
+     *         without waiting and `may_wait` is false; `std::nullopt` once
+     *         every file has been handed out or the buffer was abandoned.
+     */
+    template <typename T>
+    std::optional<std::vector<size_t>> take(reorder_buffer<T>& lines, bool may_wait, size_t max_files)
+    {
+        std::unique_lock guard{ lock };
+        if (first_pending == files.size() || lines.is_abandoned())
+        {
+            return std::nullopt;
+        }
+
+        const size_t end = std::min(files.size(), first_pending + look_ahead);
+
+        std::optional<size_t> largest;
+        for (size_t ordinal = first_pending; ordinal < end; ++ordinal)
+        {
+            if (!dispatched[ordinal]
+                && files[ordinal].size >= large_file_size
+                && (!largest.has_value() || files[ordinal].size > files[*largest].size))
+            {
+                largest = ordinal;
+            }
+        }
+
+        std::vector<size_t> result;
+        if (largest.has_value() && lines.try_acquire(*largest))
+        {
+            mark(*largest);
+            result.push_back(*largest);
+        }
+        else
+        {
+            std::uint64_t bytes{ 0 };
+            for (size_t ordinal = first_pending; ordinal < end && result.size() < std::max<size_t>(max_files, 1); ++ordinal)
+            {
+                if (dispatched[ordinal])
+                {
+                    continue;
+                }
+
+                if (!result.empty() && (files[ordinal].size >= large_file_size || bytes + files[ordinal].size > group_size))
+                {
+                    break;
+                }
+
+                if (!lines.try_acquire(ordinal))
+                {
+                    break;
+                }
+
+                mark(ordinal);
+                result.push_back(ordinal);
+                bytes += files[ordinal].size;
+            }
+        }
+
+        if (!result.empty() || !may_wait)
+        {
+            task_count += result.empty() ? 0 : 1;
+            return result;
+        }
+
+        const size_t ordinal = first_pending;
+        mark(ordinal);
+        ++task_count;
+        guard.unlock();
+
+        if (!lines.acquire(ordinal))
+        {
+            return std::nullopt;
+        }
+
+        return std::vector{ ordinal };
+    }
+
+    size_t tasks()
+    {
+        std::lock_guard guard{ lock };
+        return task_count;
+    }
+};
+
+/**
+ * @brief Run the batch pipeline over the files of a directory corpus.
+ * @param sink Callable receiving each `batch_line&` in file order; a
+ *        failure recorded in a line is rethrown before it reaches the sink.
+ */
+template <typename F>
+requires std::is_invocable_v<F&, batch_line&>
+pipeline_statistics run_batch_pipeline(
+    const std::filesystem::path& root,
+    std::span<const inf_listing> files,
+    const std::optional<std::filesystem::path>& cache_directory,
+    bool with_bloom_filters,
+    const pipeline_settings& stages,
+    F&& sink)
+{
+    static constexpr size_t byte_budget{ 64 * 1024 * 1024 };
+
+    const size_t reader_count = std::max<size_t>(stages.readers, 1);
+    const size_t parser_count = std::max<size_t>(stages.parsers, 1);
+
+    const bool io_ring = io_ring_reader::is_supported();
+    const size_t reads_per_reader = io_ring ? std::max<size_t>(stages.ring_depth, 1) : 1;
+
+    bounded_queue<read_item> reads{ stages.read_ahead };
+    const size_t window = stages.read_ahead + reader_count * reads_per_reader + 2 * parser_count;
+    reorder_buffer<batch_line> lines{ window, byte_budget };
+    batch_schedule schedule{ files, window };
+    std::atomic<size_t> active_readers{ reader_count };
+    std::atomic<size_t> timeouts{ 0 };
+
+    // without time limits no watchdog runs and parses get an empty token
+    std::optional<deadline_watchdog> watchdog;
+    if (stages.file_timeout.has_value() || stages.deadline.has_value())
+    {
+        watchdog.emplace();
+    }
+
+    auto expired = [&stages]
+        {
+            return stages.deadline.has_value() && deadline_watchdog::clock::now() >= *stages.deadline;
+        };
+
+    auto time_out = [&](corpus_entry& entry)
+        {
+            entry.manufacturers.reset();
+            entry.version.reset();
+            entry.diagnostics.clear();
+            entry.error = expired() ? "Batch deadline reached" : "Parsing timed out";
+            timeouts.fetch_add(1, std::memory_order_relaxed);
+        };
+
+    auto read_mapped = [&]
+        {
+            while (std::optional<std::vector<size_t>> task = schedule.take(lines, true, batch_schedule::group_files))
+            {
+                for (size_t ordinal : *task)
+                {
+                    read_item item{ .ordinal = ordinal, .entry = {}, .digest = std::nullopt, .failure = nullptr };
+                    try
+                    {
+                        item.entry = make_corpus_entry(root, files[ordinal].path);
+                        if (!expired())
+                        {
+                            item.digest = hash_corpus_entry(item.entry, stages.limits);
+                        }
+                    }
+                    catch (...)
+                    {
+                        item.failure = std::current_exception();
+                    }
+
+                    reads.push(std::move(item));
+                }
+            }
+        };
+
+    auto read_through_ring = [&](io_ring_reader& ring)
+        {
+            auto push_completion = [&](const io_ring_completion& done)
+                {
+                    read_item item{ .ordinal = done.ordinal, .entry = {}, .digest = std::nullopt, .failure = nullptr };
+                    try
+                    {
+                        item.entry = make_corpus_entry(root, files[done.ordinal].path);
+                        if (done.failed)
+                        {
+                            item.entry.error = "Failed to read the INF";
+                        }
+                        else
+                        {
+                            item.digest = hash_corpus_entry(item.entry, done.contents, stages.limits);
+                        }
+                    }
+                    catch (...)
+                    {
+                        item.failure = std::current_exception();
+                    }
+
+                    reads.push(std::move(item));
+                };
+
+            bool exhausted{ false };
+            while (true)
+            {
+                if (!exhausted && !ring.full())
+                {
+                    // only wait for the window with nothing in flight: a
+                    // pending read may be the head everyone waits for
+                    std::optional<std::vector<size_t>> task = schedule.take(
+                        lines,
+                        ring.in_flight() == 0,
+                        ring.depth() - ring.in_flight());
+
+                    exhausted = !task.has_value();
+                    for (size_t ordinal : task.value_or(std::vector<size_t>{}))
+                    {
+                        read_item item{ .ordinal = ordinal, .entry = {}, .digest = std::nullopt, .failure = nullptr };
+                        try
+                        {
+                            item.entry = make_corpus_entry(root, files[ordinal].path);
+                            if (!expired())
+                            {
+                                bool queued{ false };
+                                record_failure(item.entry, [&] { queued = ring.submit(ordinal, files[ordinal].path); });
+                                if (queued)
+                                {
+                                    continue;
+                                }
+
+                                // larger than a ring buffer
+                                if (item.entry.error.empty())
+                                {
+                                    item.digest = hash_corpus_entry(item.entry, stages.limits);
+                                }
+                            }
+                        }
+                        catch (...)
+                        {
+                            item.failure = std::current_exception();
+                        }
+
+                        reads.push(std::move(item));
+                    }
+
+                    if (task.has_value() && !task->empty())
+                    {
+                        continue;
+                    }
+                }
+
+                if (ring.in_flight() == 0)
+                {
+                    if (exhausted)
+                    {
+                        break;
+                    }
+
+                    continue;
+                }
+
+                ring.complete(push_completion);
+            }
+        };
+
+    auto read = [&]
+        {
+            try
+            {
+                std::optional<io_ring_reader> ring;
+                if (io_ring)
+                {
+                    try
+                    {
+                        ring.emplace(stages.ring_depth, stages.ring_buffer_size);
+                    }
+                    catch (const std::runtime_error&)
+                    {
+                    }
+                }
+
+                if (ring.has_value())
+                {
+                    read_through_ring(*ring);
+                }
+                else
+                {
+                    read_mapped();
+                }
+            }
+            catch (...)
+            {
+                lines.abandon(std::current_exception());
+            }
+
+            if (active_readers.fetch_sub(1) == 1)
+            {
+                reads.close();
+            }
+        };
+
+    auto parse = [&]
+        {
+            while (std::optional<read_item> item = reads.pop())
+            {
+                batch_line line{ .json = {}, .filter = std::nullopt, .failure = item->failure };
+                if (!line.failure)
+                {
+                    try
+                    {
+                        // readers skip hashing past the deadline
+                        if (item->entry.error.empty() && (!item->digest.has_value() || expired()))
+                        {
+                            time_out(item->entry);
+                        }
+                        else if (item->digest.has_value())
+                        {
+                            std::optional<deadline_watchdog::watch> watch;
+                            std::stop_token stop;
+                            if (watchdog.has_value())
+                            {
+                                const auto file_deadline = stages.file_timeout.has_value()
+                                    ? deadline_watchdog::clock::now() + *stages.file_timeout
+                                    : deadline_watchdog::clock::time_point::max();
+                                watch.emplace(*watchdog, std::min(file_deadline, stages.deadline.value_or(file_deadline)));
+                                stop = watch->token();
+                            }
+
+                            if (cache_directory.has_value())
+                            {
+                                parse_corpus_entry(item->entry, *item->digest, *cache_directory, stop, stages.mode);
+                            }
+                            else
+                            {
+                                parse_corpus_entry(item->entry, stop, stages.mode);
+                            }
+
+                            // a stop after a finished parse, or after a parse that
+                            // failed on its own, changes nothing
+                            if (item->entry.cancelled)
+                            {
+                                time_out(item->entry);
+                            }
+                        }
+
+                        line.json = nlohmann::json(item->entry).dump();
+                        if (with_bloom_filters)
+                        {
+                            line.filter = build_bloom_filter(item->entry);
+                        }
+                    }
+                    catch (...)
+                    {
+                        line.failure = std::current_exception();
+                    }
+                }
+
+                const size_t bytes = line.bytes();
+                lines.push(item->ordinal, std::move(line), bytes);
+            }
+        };
+
+    // declared last so that the stages are joined before the queues they
+    // use are destroyed
+    std::vector<std::jthread> workers;
+    try
+    {
+        for (size_t i = 0; i < reader_count; ++i)
+        {
+            workers.emplace_back(read);
+        }
+
+        for (size_t i = 0; i < parser_count; ++i)
+        {
+            workers.emplace_back(parse);
+        }
+
+        for (size_t ordinal = 0; ordinal < files.size(); ++ordinal)
+        {
+            batch_line line = lines.pop();
+            if (line.failure)
+            {
+                std::rethrow_exception(line.failure);
+            }
+
+            sink(line);
+        }
+    }
+    catch (...)
+    {
+        lines.abandon();
+        throw;
+    }
+
+    return pipeline_statistics{
+        .read_queue = reads.statistics(),
+        .peak_buffered_bytes = lines.peak_buffered_bytes(),
+        .read_tasks = schedule.tasks(),
+        .timeouts = timeouts.load(),
+        .io_ring = io_ring };
+}
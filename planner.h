@@ -0,0 +1,241 @@
+/**
+ * @file planner.h
+ * @brief Driver-set planning: a small set of INF packages covering every
+ *        device of an inventory.
+ *
+ * Identical devices (same ID lists) are planned once. A package covers a
+ * device when it lists any of the device's hardware or compatible IDs, and
+ * coverage is kept as one bitset row per package over the distinct devices.
+ * Rows only span the words between their first and last device, so the
+ * sparse matrices of real corpora stay small.
+ *
+ * Minimum set cover is NP-hard; the planner uses the greedy heuristic
+ * (within a factor of ln n of optimal) in its lazy form: gains only shrink
+ * as devices get covered, so a package popped from the priority queue is
+ * recounted and taken as soon as its fresh gain still beats the next
+ * stale one.
+ */
+
+/**
+ * @class coverage_row
+ * @brief Devices covered by one package: bit `d` of `words` stands for
+ *        device `first_word * 64 + d`.
+ */
+class coverage_row
+{
+public:
+    static constexpr std::uint32_t word_bits{ 64 };
+
+    std::uint32_t entry;
+    std::uint32_t first_word;
+    std::vector<std::uint64_t> words;
+};
+
+/**
+ * @class coverage_matrix
+ * @brief Package × device coverage of an inventory. `devices[d]` is the
+ *        first instance of distinct device `d`, `instances[d]` how many
+ *        devices of the inventory share its IDs.
+ */
+class coverage_matrix
+{
+public:
+    std::vector<const inventory_device*> devices;
+    std::vector<std::uint32_t> instances;
+    std::vector<coverage_row> rows;
+};
+
+/**
+ * @brief Build the coverage of an inventory by a corpus.
+ */
+coverage_matrix build_coverage_matrix(
+    const inventory& fleet,
+    const hardware_id_dictionary& dictionary)
+{
+    constexpr std::uint32_t word_bits = coverage_row::word_bits;
+
+    coverage_matrix result;
+
+    std::vector<const inventory_device*> all_devices;
+    for (const inventory_machine& machine : fleet.machines)
+    {
+        for (const inventory_device& device : machine.devices)
+        {
+            all_devices.push_back(&device);
+        }
+    }
+
+    std::ranges::stable_sort(all_devices, std::less{}, &inventory_device::ids);
+    for (const inventory_device* device : all_devices)
+    {
+        if (!result.devices.empty() && result.devices.back()->ids == device->ids)
+        {
+            ++result.instances.back();
+            continue;
+        }
+
+        result.devices.push_back(device);
+        result.instances.push_back(1);
+    }
+
+    // (entry, device) pairs, sorted so that every row is built in one run
+    const std::vector<std::optional<std::uint32_t>> matches = intersect_sorted_keys(fleet.keys, dictionary.keys);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> coverage;
+    for (size_t device = 0; device < result.devices.size(); ++device)
+    {
+        for (std::uint32_t key : result.devices[device]->ids)
+        {
+            if (!matches[key].has_value())
+            {
+                continue;
+            }
+
+            for (const hardware_id_posting& posting : dictionary.postings_of(*matches[key]))
+            {
+                coverage.emplace_back(posting.entry, static_cast<std::uint32_t>(device));
+            }
+        }
+    }
+
+    std::ranges::sort(coverage);
+    auto repeated = std::ranges::unique(coverage);
+    coverage.erase(repeated.begin(), repeated.end());
+
+    for (auto first = coverage.begin(); first != coverage.end();)
+    {
+        auto last = std::find_if(first, coverage.end(), [first](const auto& item) { return item.first != first->first; });
+
+        const std::uint32_t first_word = first->second / word_bits;
+        coverage_row row{
+            .entry = first->first,
+            .first_word = first_word,
+            .words = std::vector<std::uint64_t>((last - 1)->second / word_bits - first_word + 1, 0) };
+
+        for (auto item = first; item != last; ++item)
+        {
+            row.words[item->second / word_bits - first_word] |= std::uint64_t{ 1 } << (item->second % word_bits);
+        }
+
+        result.rows.push_back(std::move(row));
+        first = last;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Number of devices of a row not yet covered. Plain word loops: the
+ *        and-not vectorizes and the population count maps to `popcnt`.
+ */
+std::uint32_t count_uncovered(const coverage_row& row, std::span<const std::uint64_t> covered) noexcept
+{
+    const std::uint64_t* base = covered.data() + row.first_word;
+
+    std::uint32_t result{ 0 };
+    for (size_t word = 0; word < row.words.size(); ++word)
+    {
+        result += static_cast<std::uint32_t>(std::popcount(row.words[word] & ~base[word]));
+    }
+
+    return result;
+}
+
+/**
+ * @class planned_package
+ * @brief A selected package and the number of distinct devices it newly
+ *        covers.
+ */
+class planned_package
+{
+public:
+    const corpus_entry* entry;
+    std::uint32_t devices;
+};
+
+/**
+ * @class uncovered_device
+ * @brief A distinct device no package covers, with its instance count.
+ */
+class uncovered_device
+{
+public:
+    const inventory_device* device;
+    std::uint32_t instances;
+};
+
+/**
+ * @class driver_plan
+ * @brief Selected packages in selection order plus the devices left
+ *        uncovered. Pointers refer to the inventory and the corpus.
+ */
+class driver_plan
+{
+public:
+    std::vector<planned_package> packages;
+    std::vector<uncovered_device> uncovered;
+};
+
+/**
+ * @brief Pick packages greedily until every coverable device is covered.
+ */
+driver_plan plan_driver_set(const coverage_matrix& matrix, const corpus& entries)
+{
+    class candidate
+    {
+    public:
+        std::uint32_t gain;
+        std::uint32_t row;
+    };
+
+    // highest gain first, then corpus order
+    auto lower_priority = [](const candidate& left, const candidate& right)
+        {
+            return left.gain != right.gain ? left.gain < right.gain : left.row > right.row;
+        };
+
+    std::priority_queue<candidate, std::vector<candidate>, decltype(lower_priority)> queue{ lower_priority };
+    constexpr size_t word_bits = coverage_row::word_bits;
+    std::vector<std::uint64_t> covered((matrix.devices.size() + word_bits - 1) / word_bits, 0);
+
+    for (size_t row = 0; row < matrix.rows.size(); ++row)
+    {
+        queue.push(candidate{ .gain = count_uncovered(matrix.rows[row], covered), .row = static_cast<std::uint32_t>(row) });
+    }
+
+    driver_plan result;
+    while (!queue.empty())
+    {
+        const candidate top = queue.top();
+        queue.pop();
+
+        const coverage_row& row = matrix.rows[top.row];
+        const std::uint32_t gain = count_uncovered(row, covered);
+        if (gain == 0)
+        {
+            continue;
+        }
+
+        if (!queue.empty() && gain < queue.top().gain)
+        {
+            queue.push(candidate{ .gain = gain, .row = top.row });
+            continue;
+        }
+
+        for (size_t word = 0; word < row.words.size(); ++word)
+        {
+            covered[row.first_word + word] |= row.words[word];
+        }
+
+        result.packages.push_back(planned_package{ .entry = &entries[row.entry], .devices = gain });
+    }
+
+    for (size_t device = 0; device < matrix.devices.size(); ++device)
+    {
+        if ((covered[device / word_bits] & (std::uint64_t{ 1 } << (device % word_bits))) == 0)
+        {
+            result.uncovered.push_back(uncovered_device{ .device = matrix.devices[device], .instances = matrix.instances[device] });
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,399 @@
+/**
+ * @file ranking.h
+ * @brief Driver ranking: which INF model Windows would select for a device,
+ *        given its ordered hardware and compatible IDs.
+ *
+ * Candidates are ranked the way Plug and Play does, with a rank of the
+ * form `0xSSGGTHHH` where lower is better:
+ *  - `SS` signature score: `0x0D` for packages with a catalog file (taken as
+ *    signed; the signature itself is not verified), `0x80` otherwise;
+ *  - `GG` feature score: always `0xFF`, `FeatureScore` is not extracted;
+ *  - `T` identifier score: 0 when a device hardware ID matches the model's
+ *    hardware ID, 1 for a device hardware ID matching a model compatible ID,
+ *    2 and 3 for device compatible IDs matching those;
+ *  - `HHH` position: the matching ID's index in the device list, then its
+ *    index in the model's list.
+ *
+ * Only models listed under a models-section decoration that applies to the
+ * target platform are candidates, as Windows ignores the other sections.
+ * Equal ranks prefer the more specific applicable decoration, then the
+ * newer `DriverVer` date, then the higher version.
+ *
+ * The corpus is indexed once by folded ID, so ranking a device only visits
+ * the models that list one of its IDs.
+ */
+
+/**
+ * @brief Parse a `DriverVer` date (`mm/dd/yyyy`).
+ * @return `yyyymmdd`, or 0 if the date is malformed.
+ */
+std::uint32_t parse_driver_date(std::string_view text) noexcept
+{
+    std::uint32_t parts[3]{};
+    for (std::uint32_t& part : parts)
+    {
+        const size_t delimiter = text.find('/');
+        const std::string_view value = text.substr(0, delimiter);
+
+        auto [last, error] = std::from_chars(value.data(), value.data() + value.size(), part);
+        if (error != std::errc{} || last != value.data() + value.size())
+        {
+            return 0;
+        }
+
+        text.remove_prefix(delimiter == std::string_view::npos ? text.size() : delimiter + 1);
+    }
+
+    const auto [month, day, year] = parts;
+    return month >= 1 && month <= 12 && day >= 1 && day <= 31 && year <= 9999
+        ? year * 10000 + month * 100 + day
+        : 0;
+}
+
+/**
+ * @brief Parse a `DriverVer` version (`w.x.y.z`, trailing parts optional)
+ *        into one integer that orders like the version.
+ * @return Packed 16-bit parts, or 0 if the version is malformed.
+ */
+std::uint64_t parse_driver_version(std::string_view text) noexcept
+{
+    std::uint64_t result{ 0 };
+    for (int part = 0; part < 4; ++part)
+    {
+        std::uint16_t value{ 0 };
+        if (!text.empty())
+        {
+            const size_t delimiter = text.find('.');
+            const std::string_view digits = text.substr(0, delimiter);
+
+            auto [last, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            if (error != std::errc{} || last != digits.data() + digits.size())
+            {
+                return 0;
+            }
+
+            text.remove_prefix(delimiter == std::string_view::npos ? text.size() : delimiter + 1);
+        }
+
+        result = (result << 16) | value;
+    }
+
+    return text.empty() ? result : 0;
+}
+
+/**
+ * @brief Specificity of a models-section decoration: the number of
+ *        non-empty parts (`NTamd64.10.0...16299` has four, no decoration
+ *        none).
+ */
+int decoration_specificity(std::string_view architecture) noexcept
+{
+    int result{ 0 };
+    while (!architecture.empty())
+    {
+        const size_t delimiter = architecture.find('.');
+        result += delimiter != 0 ? 1 : 0;
+        architecture.remove_prefix(delimiter == std::string_view::npos ? architecture.size() : delimiter + 1);
+    }
+
+    return result;
+}
+
+/**
+ * @class platform_decoration
+ * @brief A parsed models-section decoration,
+ *        `NT[architecture][.major[.minor[.product-type[.suite-mask[.build]]]]]`.
+ *
+ * Parts left out are empty: they match any target, and a target that
+ * leaves them out matches any decoration. `architecture` is lower case.
+ */
+class platform_decoration
+{
+public:
+    std::string architecture;
+    std::optional<std::uint32_t> major_version;
+    std::optional<std::uint32_t> minor_version;
+    std::optional<std::uint32_t> product_type;
+    std::optional<std::uint32_t> suite_mask;
+    std::optional<std::uint32_t> build_number;
+};
+
+/**
+ * @brief Parse a models-section decoration (`NTamd64.10.0...16299`); the
+ *        suite mask is hexadecimal, with or without `0x`.
+ * @return The decoration, or `std::nullopt` if it is not of the `NT` form.
+ */
+std::optional<platform_decoration> parse_platform_decoration(std::string_view text)
+{
+    if (text.size() < 2 || std::toupper(static_cast<unsigned char>(text[0])) != 'N' || std::toupper(static_cast<unsigned char>(text[1])) != 'T')
+    {
+        return std::nullopt;
+    }
+
+    text.remove_prefix(2);
+    const size_t end = text.find('.');
+
+    platform_decoration result;
+    std::ranges::transform(text.substr(0, end), std::back_inserter(result.architecture), [](char c)
+        {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        });
+
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    for (std::optional<std::uint32_t>* part : { &result.major_version, &result.minor_version, &result.product_type, &result.suite_mask, &result.build_number })
+    {
+        if (text.empty())
+        {
+            break;
+        }
+
+        const size_t delimiter = text.find('.');
+        std::string_view digits = text.substr(0, delimiter);
+        text.remove_prefix(delimiter == std::string_view::npos ? text.size() : delimiter + 1);
+        if (digits.empty())
+        {
+            continue;
+        }
+
+        int base{ 10 };
+        if (part == &result.suite_mask)
+        {
+            base = 16;
+            if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+            {
+                digits.remove_prefix(2);
+            }
+        }
+
+        std::uint32_t value{ 0 };
+        auto [last, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+        if (error != std::errc{} || last != digits.data() + digits.size())
+        {
+            return std::nullopt;
+        }
+
+        *part = value;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Test whether Windows would read a models section with this
+ *        decoration on the target platform.
+ *
+ * The architecture must match unless the decoration has none; the OS
+ * version and build are minimums, the product type must be equal and the
+ * suite mask bits must all be present. Undecorated sections are only read
+ * on x86: 64-bit Windows requires decorated models sections.
+ */
+bool decoration_applies(std::string_view decoration, const platform_decoration& target)
+{
+    if (decoration.empty())
+    {
+        return target.architecture == "x86";
+    }
+
+    const std::optional<platform_decoration> parsed = parse_platform_decoration(decoration);
+    if (!parsed.has_value())
+    {
+        return false;
+    }
+
+    auto both = [](const std::optional<std::uint32_t>& left, const std::optional<std::uint32_t>& right)
+        {
+            return left.has_value() && right.has_value();
+        };
+
+    const bool version_applies = !both(parsed->major_version, target.major_version)
+        || std::pair{ *parsed->major_version, parsed->minor_version.value_or(0) }
+            <= std::pair{ *target.major_version, target.minor_version.value_or(std::numeric_limits<std::uint32_t>::max()) };
+
+    return (parsed->architecture.empty() || parsed->architecture == target.architecture)
+        && version_applies
+        && (!both(parsed->product_type, target.product_type) || *parsed->product_type == *target.product_type)
+        && (!both(parsed->suite_mask, target.suite_mask) || (*parsed->suite_mask & ~*target.suite_mask) == 0)
+        && (!both(parsed->build_number, target.build_number) || *parsed->build_number <= *target.build_number);
+}
+
+/**
+ * @class ranked_driver
+ * @brief One candidate model for a device, best match only.
+ */
+class ranked_driver
+{
+public:
+    std::uint32_t rank;
+    int specificity;
+    std::uint32_t driver_date;
+    std::uint64_t driver_version;
+    hardware_id_posting posting;
+    std::string_view decoration;
+
+    /**
+     * @brief Selection order: the driver Windows would pick comes first.
+     */
+    friend bool operator<(const ranked_driver& left, const ranked_driver& right) noexcept
+    {
+        return std::tuple{ left.rank, -left.specificity, ~left.driver_date, ~left.driver_version }
+            < std::tuple{ right.rank, -right.specificity, ~right.driver_date, ~right.driver_version };
+    }
+};
+
+/**
+ * @class resolved_driver
+ * @brief A ranked candidate with the corpus data it refers to.
+ */
+class resolved_driver
+{
+public:
+    const ranked_driver* driver;
+    const corpus_entry* entry;
+    const manufacturer* maker;
+    const model* device;
+};
+
+/**
+ * @class ranking_index
+ * @brief Corpus preprocessed for ranking: the hardware-ID trie plus the
+ *        signature and `DriverVer` values of every entry.
+ *
+ * Views and postings point into the corpus, which must outlive the index.
+ */
+class ranking_index
+{
+private:
+    class package
+    {
+    public:
+        bool is_signed;
+        std::uint32_t driver_date;
+        std::uint64_t driver_version;
+    };
+
+    static constexpr std::uint32_t signed_score{ 0x0D };
+    static constexpr std::uint32_t unsigned_score{ 0x80 };
+    static constexpr std::uint32_t feature_score{ 0xFF };
+    static constexpr std::uint32_t max_position{ 0xFFF };
+
+    const corpus& entries;
+    hardware_id_trie hardware_ids;
+    std::vector<package> packages;
+
+public:
+    explicit ranking_index(const corpus& entries)
+        : entries{ entries },
+        hardware_ids{ build_hardware_id_trie(entries) }
+    {
+        packages.reserve(entries.size());
+        for (const corpus_entry& entry : entries)
+        {
+            const package_version version = entry.version.value_or(package_version{});
+            packages.push_back(package{
+                .is_signed = !version.catalog_file.empty(),
+                .driver_date = parse_driver_date(version.driver_date),
+                .driver_version = parse_driver_version(version.driver_version) });
+        }
+    }
+
+    /**
+     * @brief Look up the corpus data of a candidate.
+     */
+    resolved_driver resolve(const ranked_driver& driver) const
+    {
+        const corpus_entry& entry = entries[driver.posting.entry];
+        const manufacturer& maker = (*entry.manufacturers)[driver.posting.manufacturer];
+        return resolved_driver{
+            .driver = &driver,
+            .entry = &entry,
+            .maker = &maker,
+            .device = &maker.devices[driver.posting.device] };
+    }
+
+    /**
+     * @brief Rank every model matching any ID of a device.
+     * @param device_hardware_ids Device hardware IDs, most specific first.
+     * @param device_compatible_ids Device compatible IDs, most specific
+     *        first.
+     * @param platform Platform the device runs; models with no decoration
+     *        applying to it are left out.
+     * @return Candidates in selection order, one per model.
+     */
+    std::vector<ranked_driver> rank(
+        std::span<const std::string> device_hardware_ids,
+        std::span<const std::string> device_compatible_ids,
+        const platform_decoration& platform) const
+    {
+        std::vector<ranked_driver> candidates;
+
+        auto collect = [&](std::span<const std::string> device_ids, std::uint32_t device_list_score)
+            {
+                for (size_t position = 0; position < device_ids.size(); ++position)
+                {
+                    for (const hardware_id_posting& posting : hardware_ids.find(fold_key(device_ids[position])))
+                    {
+                        const package& source = packages[posting.entry];
+                        const model& device = (*entries[posting.entry].manufacturers)[posting.manufacturer].devices[posting.device];
+
+                        const std::uint32_t identifier_score = device_list_score + (posting.hardware_id == 0 ? 0 : 1);
+                        const std::uint32_t match_position = static_cast<std::uint32_t>(std::min<size_t>(
+                            max_position,
+                            position * 0x100 + posting.hardware_id));
+
+                        std::optional<std::string_view> decoration;
+                        int specificity{ 0 };
+                        for (const std::string& architecture : device.architectures)
+                        {
+                            if (!decoration_applies(architecture, platform))
+                            {
+                                continue;
+                            }
+
+                            if (const int value = decoration_specificity(architecture)
+                                ; !decoration.has_value() || value > specificity)
+                            {
+                                decoration = architecture;
+                                specificity = value;
+                            }
+                        }
+
+                        if (!decoration.has_value())
+                        {
+                            continue;
+                        }
+
+                        candidates.push_back(ranked_driver{
+                            .rank = ((source.is_signed ? signed_score : unsigned_score) << 24)
+                                | (feature_score << 16)
+                                | (identifier_score << 12)
+                                | match_position,
+                            .specificity = specificity,
+                            .driver_date = source.driver_date,
+                            .driver_version = source.driver_version,
+                            .posting = posting,
+                            .decoration = *decoration });
+                    }
+                }
+            };
+
+        collect(device_hardware_ids, 0);
+        collect(device_compatible_ids, 2);
+
+        // keep the best match of each model
+        auto model_of = [](const ranked_driver& candidate)
+            {
+                return std::tuple{ candidate.posting.entry, candidate.posting.manufacturer, candidate.posting.device };
+            };
+
+        std::ranges::sort(candidates, [&model_of](const ranked_driver& left, const ranked_driver& right)
+            {
+                return model_of(left) != model_of(right) ? model_of(left) < model_of(right) : left < right;
+            });
+
+        auto duplicates = std::ranges::unique(candidates, std::equal_to{}, model_of);
+        candidates.erase(duplicates.begin(), duplicates.end());
+
+        std::ranges::sort(candidates, std::less{});
+        return candidates;
+    }
+};
@@ -19,6 +19,49 @@ public:
     std::vector<std::wstring> architectures;
 };
 
+/**
+ * @brief Order-dependent hash combination.
+ */
+constexpr std::uint64_t combine_hash(std::uint64_t seed, std::uint64_t value) noexcept
+{
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * @class hardware_id
+ * @brief Hardware or compatible ID canonicalized at extraction time.
+ *
+ * `text` keeps the original spelling, trimmed of blanks; `folded_hash` is
+ * the case-insensitive hash of it, computed once so that keys built from
+ * IDs hash and compare by integer before falling back to text comparison.
+ */
+class hardware_id
+{
+public:
+    std::wstring text;
+    std::uint64_t folded_hash;
+
+    explicit hardware_id(std::wstring_view value)
+    {
+        const size_t first = value.find_first_not_of(L" \t");
+        const size_t last = value.find_last_not_of(L" \t");
+        text = first == std::wstring_view::npos
+            ? std::wstring{}
+            : std::wstring{ value.substr(first, last - first + 1) };
+        folded_hash = std::hash<key_name_view>{}(key_name_view{ text.data(), text.size() });
+    }
+
+    /**
+     * @brief Case-insensitive equality; differing hashes answer without
+     *        touching the text.
+     */
+    friend bool operator==(const hardware_id& left, const hardware_id& right) noexcept
+    {
+        return left.folded_hash == right.folded_hash
+            && key_name_view{ left.text.data(), left.text.size() } == key_name_view{ right.text.data(), right.text.size() };
+    }
+};
+
 /**
  * @class device_description_line
  * @brief Parsed representation of a device entry in a models section.
@@ -36,108 +79,496 @@ class device_description_line
 public:
     key_name device_description;
     section_name install_section;
-    std::vector<std::wstring> hardware_ids;
+    std::vector<hardware_id> hardware_ids;
+};
+
+/**
+ * @class version_info
+ * @brief Fields of the `[Version]` section used to rank and triage drivers.
+ *
+ * Example lines:
+ *   `Class = Net`, `Provider = %ProviderName%`, `CatalogFile = net.cat`,
+ *   `DriverVer = 04/21/2009,1.0.0.1`
+ *
+ * `catalog_file` is the undecorated `CatalogFile` if present, otherwise the
+ * first decorated one (`CatalogFile.NTamd64`); a package with a catalog is
+ * normally signed. `driver_date` and `driver_version` are the two
+ * `DriverVer` fields as written.
+ */
+class version_info
+{
+public:
+    std::wstring class_name;
+    std::wstring provider;
+    std::wstring catalog_file;
+    std::wstring driver_date;
+    std::wstring driver_version;
+};
+
+/**
+ * @class triage_info
+ * @brief What classifies an INF without reading its models: the
+ *        `[Version]` fields, `ClassGuid`, and whether a `[Manufacturer]`
+ *        section exists. Non-driver INFs such as `errata.inf` have none.
+ */
+class triage_info
+{
+public:
+    version_info version;
+    std::wstring class_guid;
+    bool has_manufacturer;
 };
 
+/**
+ * @class line_diagnostic
+ * @brief A line skipped by a lenient extractor: its section, its 1-based
+ *        position within the section and the reason. SetupAPI does not
+ *        expose file line numbers, so the position is section-relative.
+ */
+class line_diagnostic
+{
+public:
+    section_name section;
+    size_t line;
+    inf_error reason;
+};
+
+/**
+ * @brief Parse one `[Manufacturer]` line.
+ * @param line A `line` or `snapshot_line`.
+ */
+template <typename inf_line>
+std::expected<manufacturer_line, inf_error> parse_manufacturer_line(const inf_line& line)
+{
+    const auto fields = line.try_fields();
+    if (!fields.has_value())
+    {
+        return std::unexpected{ fields.error() };
+    }
+
+    const std::expected<key_name_view, inf_error> key = line.try_key();
+    if (!key.has_value())
+    {
+        return std::unexpected{ key.error() };
+    }
+
+    manufacturer_line make;
+    make.name = key_name{ *key };
+    if (std::ranges::empty(*fields))
+    {
+        make.models_section_name = make.name;
+        return make;
+    }
+
+    make.models_section_name = section_name(std::from_range, (*fields)[0]);
+    make.architectures.reserve(std::ranges::size(*fields) - 1);
+    if (std::expected<void, inf_error> appended = line.try_append_fields(make.architectures, 1)
+        ; !appended.has_value())
+    {
+        return std::unexpected{ appended.error() };
+    }
+
+    return make;
+}
+
+/**
+ * @brief Parse one line of a models section.
+ * @param line A `line` or `snapshot_line`.
+ */
+template <typename inf_line>
+std::expected<device_description_line, inf_error> parse_device_description_line(const inf_line& line)
+{
+    const auto fields = line.try_fields();
+    if (!fields.has_value())
+    {
+        return std::unexpected{ fields.error() };
+    }
+
+    if (std::ranges::empty(*fields))
+    {
+        return std::unexpected{ inf_error::missing_install_section };
+    }
+
+    const std::expected<key_name_view, inf_error> key = line.try_key();
+    if (!key.has_value())
+    {
+        return std::unexpected{ key.error() };
+    }
+
+    device_description_line desc;
+    desc.device_description = *key;
+    desc.install_section = section_name(std::from_range, (*fields)[0]);
+    desc.hardware_ids.reserve(std::ranges::size(*fields) - 1);
+    if (std::expected<void, inf_error> appended = line.try_append_fields(desc.hardware_ids, 1)
+        ; !appended.has_value())
+    {
+        return std::unexpected{ appended.error() };
+    }
+
+    return desc;
+}
+
+/**
+ * @brief Fold one `[Version]` line into `result`; lines without a value and
+ *        unknown keys are ignored.
+ * @param line A `line` or `snapshot_line`.
+ */
+template <typename inf_line>
+std::expected<void, inf_error> read_version_line(const inf_line& line, version_info& result)
+{
+    static constexpr key_name_view catalog_key{ L"CatalogFile" };
+    static constexpr wchar_t delimiter = '.';
+
+    const std::expected<size_t, inf_error> fields = line.try_size();
+    if (!fields.has_value())
+    {
+        return std::unexpected{ fields.error() };
+    }
+
+    if (*fields == 0)
+    {
+        return {};
+    }
+
+    const std::expected<key_name_view, inf_error> read_key = line.try_key();
+    if (!read_key.has_value())
+    {
+        return std::unexpected{ read_key.error() };
+    }
+
+    const key_name_view key = *read_key;
+
+    std::wstring* target{ nullptr };
+    if (key == L"Class")
+    {
+        target = &result.class_name;
+    }
+    else if (key == L"Provider")
+    {
+        target = &result.provider;
+    }
+    else if (key == catalog_key)
+    {
+        target = &result.catalog_file;
+    }
+    else if (key.starts_with(catalog_key)
+        && key.size() > catalog_key.size()
+        && key[catalog_key.size()] == delimiter
+        && result.catalog_file.empty())
+    {
+        target = &result.catalog_file;
+    }
+    else if (key == L"DriverVer")
+    {
+        target = &result.driver_date;
+    }
+    else
+    {
+        return {};
+    }
+
+    std::expected<std::wstring_view, inf_error> value = line.try_field_at(0);
+    if (!value.has_value())
+    {
+        return std::unexpected{ value.error() };
+    }
+
+    *target = *value;
+    if (target == &result.driver_date && *fields > 1)
+    {
+        std::expected<std::wstring_view, inf_error> version = line.try_field_at(1);
+        if (!version.has_value())
+        {
+            return std::unexpected{ version.error() };
+        }
+
+        result.driver_version = *version;
+    }
+
+    return {};
+}
+
+/**
+ * @brief Visit the lines of a section without throwing for INF errors.
+ *
+ * `visit` reads each line through its `try_*` accessors and returns
+ * `std::expected<void, inf_error>`; a failed visit, including a line that
+ * cannot be read, is recorded in `diagnostics` and the enumeration goes on.
+ *
+ * @return The failure of the enumeration itself, such as a missing section.
+ */
+template <typename inf_source, typename F>
+std::expected<void, inf_error> visit_section_lines(
+    const inf_source& inf,
+    section_name_view section,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop,
+    F&& visit)
+{
+    size_t position{ 0 };
+    return inf.try_for_each_line(section, [&](const auto& line)
+        {
+            ++position;
+            const std::expected<void, inf_error> visited = visit(line);
+            if (!visited.has_value())
+            {
+                diagnostics.push_back(line_diagnostic{
+                    .section = section_name{ section },
+                    .line = position,
+                    .reason = visited.error() });
+            }
+
+            return enumeration::move_next;
+        }, stop);
+}
+
 /**
  * @brief Extract all manufacturer lines from `[Manufacturer]`.
  *
  * Uses `inf_file::for_each_line` with case-insensitive matching.
  *
- * @param inf Open INF file wrapper.
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
+ * @param stop Cancels the enumeration with `operation_cancelled`; the same
+ *        holds for the other extractors.
  * @return Vector of parsed manufacturers in file order.
  * @throws std::runtime_error if the section is missing or Win32 APIs fail.
  */
-std::vector<manufacturer_line> extract_manufacturers(const inf_file& inf)
+template <typename inf_source>
+std::vector<manufacturer_line> extract_manufacturers(const inf_source& inf, std::stop_token stop = {})
 {
     std::vector<manufacturer_line> result;
 
-    inf.for_each_line(L"Manufacturer", [&result](line&& line)
+    inf.for_each_line(L"Manufacturer", [&result](auto&& line)
         {
-            manufacturer_line make;
-            make.name = key_name{ line.key() };
-            if (line.size() > 0)
-            {
-                make.models_section_name = section_name(std::from_range, line.field_at(0));
-            }
-            else
-            {
-                make.models_section_name = make.name;
-            }
+            result.push_back(value_or_throw(parse_manufacturer_line(line)));
+            return enumeration::move_next;
+        }, stop);
 
-            if (line.size() > 1)
-            {
-                make.architectures.reserve(line.size() - 1);
-                for (size_t i = 1; i < line.size(); ++i)
+    return result;
+}
+
+/**
+ * @brief Lenient `extract_manufacturers`: unreadable lines are recorded in
+ *        `diagnostics` and skipped.
+ * @return The manufacturers, or the error if `[Manufacturer]` cannot be
+ *         enumerated at all.
+ */
+template <typename inf_source>
+std::expected<std::vector<manufacturer_line>, inf_error> try_extract_manufacturers(
+    const inf_source& inf,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    std::vector<manufacturer_line> result;
+
+    return visit_section_lines(inf, L"Manufacturer", diagnostics, stop, [&result](const auto& line)
+        {
+            return parse_manufacturer_line(line).transform([&result](manufacturer_line&& make)
                 {
-                    make.architectures.emplace_back(line.field_at(i));
-                }
-            }
+                    result.push_back(std::move(make));
+                });
+        })
+        .transform([&result] { return std::move(result); });
+}
 
-            result.push_back(std::move(make));
-            return enumeration::move_next;
-        });
+/**
+ * @brief Enumerate all section names present in the INF, returning the
+ *        enumeration failure instead of throwing it.
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
+ */
+template <typename inf_source>
+std::expected<std::unordered_set<section_name>, inf_error> try_extract_sections(
+    const inf_source& inf,
+    std::stop_token stop = {})
+{
+    std::unordered_set<section_name> result;
 
-    return result;
+    return inf.try_for_each_section([&result](section_name_view raw_name)
+        {
+            result.emplace(raw_name);
+            return enumeration::move_next;
+        }, stop)
+        .transform([&result] { return std::move(result); });
 }
 
 /**
  * @brief Enumerate all section names present in the INF.
- * @param inf Open INF file wrapper.
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
  * @return Unordered set of case-insensitive section names.
+ * @throws std::runtime_error if Win32 APIs fail.
  */
-std::unordered_set<section_name> extract_sections(const inf_file& inf)
+template <typename inf_source>
+std::unordered_set<section_name> extract_sections(const inf_source& inf, std::stop_token stop = {})
 {
-    std::unordered_set<section_name> result;
+    return value_or_throw(try_extract_sections(inf, stop));
+}
+
+/**
+ * @brief Extract the `[Version]` fields of an INF.
+ *
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
+ * @param all_sections Section names of the INF; a missing `[Version]`
+ *        section yields empty fields.
+ */
+template <typename inf_source>
+version_info extract_version_info(
+    const inf_source& inf,
+    const std::unordered_set<section_name>& all_sections,
+    std::stop_token stop = {})
+{
+    static constexpr section_name_view version_section{ L"Version" };
+
+    version_info result;
+    if (!all_sections.contains(section_name{ version_section }))
+    {
+        return result;
+    }
 
-    inf.for_each_section([&result](section_name_view raw_name)
+    inf.for_each_line(version_section, [&result](auto&& line)
         {
-            result.emplace(raw_name);
+            value_or_throw(read_version_line(line, result));
             return enumeration::move_next;
-        });
+        }, stop);
 
     return result;
 }
 
+/**
+ * @brief Lenient `extract_version_info`: unreadable lines are recorded in
+ *        `diagnostics` and skipped.
+ */
+template <typename inf_source>
+std::expected<version_info, inf_error> try_extract_version_info(
+    const inf_source& inf,
+    const std::unordered_set<section_name>& all_sections,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    static constexpr section_name_view version_section{ L"Version" };
+
+    version_info result;
+    if (!all_sections.contains(section_name{ version_section }))
+    {
+        return result;
+    }
+
+    return visit_section_lines(inf, version_section, diagnostics, stop, [&result](const auto& line)
+        {
+            return read_version_line(line, result);
+        })
+        .transform([&result] { return std::move(result); });
+}
+
 /**
  * @brief Parse a models section into device-description entries.
  *
- * @param inf Open INF file wrapper.
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
  * @param models_section_name Name of a models section, with or without
  *        architecture suffix (e.g., `ASUP` or `ASUP.ntamd64.10.0...16299`).
  * @return Vector of device-description lines.
  * @throws std::runtime_error if the section exists but a line is malformed
  *         (e.g., missing install section name).
  */
+template <typename inf_source>
 std::vector<device_description_line> extract_device_descriptions(
-    const inf_file& inf,
-    section_name_view models_section_name)
+    const inf_source& inf,
+    section_name_view models_section_name,
+    std::stop_token stop = {})
 {
     std::vector<device_description_line> result;
 
-    inf.for_each_line(models_section_name, [&result](line&& device_entry)
+    inf.for_each_line(models_section_name, [&result](auto&& device_entry)
         {
-            if (device_entry.size() == 0)
+            result.push_back(value_or_throw(parse_device_description_line(device_entry)));
+            return enumeration::move_next;
+        }, stop);
+
+    return result;
+}
+
+/**
+ * @brief Lenient `extract_device_descriptions`: malformed lines, such as
+ *        ones missing the install section name, are recorded in
+ *        `diagnostics` and skipped.
+ */
+template <typename inf_source>
+std::expected<std::vector<device_description_line>, inf_error> try_extract_device_descriptions(
+    const inf_source& inf,
+    section_name_view models_section_name,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    std::vector<device_description_line> result;
+
+    return visit_section_lines(inf, models_section_name, diagnostics, stop, [&result](const auto& line)
+        {
+            return parse_device_description_line(line).transform([&result](device_description_line&& desc)
+                {
+                    result.push_back(std::move(desc));
+                });
+        })
+        .transform([&result] { return std::move(result); });
+}
+
+/**
+ * @brief Read the triage fields of an INF by key.
+ *
+ * Only `[Version]` is read: its keys are looked up with `get_line`, and
+ * `[Manufacturer]` is only tested for existence, so models sections are
+ * never touched. Only when there is no undecorated `CatalogFile` are the
+ * `[Version]` lines scanned for a decorated one, whose key is not known in
+ * advance.
+ *
+ * @param inf Open INF source: `inf_file` or `inf_snapshot`.
+ * @throws std::runtime_error if Win32 APIs fail.
+ */
+template <typename inf_source>
+triage_info extract_triage_info(const inf_source& inf)
+{
+    static constexpr section_name_view version_section{ L"Version" };
+    static constexpr key_name_view catalog_key{ L"CatalogFile" };
+
+    triage_info result{ .version = {}, .class_guid = {}, .has_manufacturer = inf.has_section(L"Manufacturer") };
+    if (!inf.has_section(version_section))
+    {
+        return result;
+    }
+
+    auto read = [&inf](key_name_view key, std::wstring& value, std::wstring* second_value = nullptr)
+        {
+            if (auto line = inf.get_line(version_section, key)
+                ; line.has_value() && line->size() > 0)
             {
-                throw std::runtime_error("install-section-name field is missing");
+                value = line->field_at(0);
+                if (second_value != nullptr && line->size() > 1)
+                {
+                    *second_value = line->field_at(1);
+                }
             }
+        };
 
-            device_description_line desc;
-            desc.device_description = device_entry.key();
-            desc.install_section = section_name(std::from_range, device_entry.field_at(0));
+    read(L"Class", result.version.class_name);
+    read(L"ClassGuid", result.class_guid);
+    read(L"Provider", result.version.provider);
+    read(L"DriverVer", result.version.driver_date, &result.version.driver_version);
+    read(catalog_key, result.version.catalog_file);
 
-            if (device_entry.size() > 1)
+    // `read_version_line` matches the decorated key; a line that cannot be
+    // read is skipped, as `key_index` skips it
+    if (result.version.catalog_file.empty())
+    {
+        inf.for_each_line(version_section, [&result](auto&& line)
             {
-                desc.hardware_ids.reserve(device_entry.size() - 1);
-                for (size_t i = 1; i < device_entry.size(); ++i)
+                version_info fields;
+                if (read_version_line(line, fields).has_value() && !fields.catalog_file.empty())
                 {
-                    desc.hardware_ids.emplace_back(device_entry.field_at(i));
+                    result.version.catalog_file = std::move(fields.catalog_file);
+                    return enumeration::stop;
                 }
-            }
 
-            result.push_back(std::move(desc));
-            return enumeration::move_next;
-        });
+                return enumeration::move_next;
+            });
+    }
 
     return result;
 }
@@ -2,7 +2,8 @@
  * @class model
  * @brief High-level report entry for a single device model.
  *
- * All strings are UTF-8 for easy JSON serialization.
+ * All strings are UTF-8 for easy JSON serialization. `decoded_hardware_ids`
+ * parallels `hardware_ids`.
  */
 class model
 {
@@ -10,6 +11,7 @@ public:
     std::string description;
     std::vector<std::string> hardware_ids;
     std::vector<std::string> architectures;
+    std::vector<decoded_hardware_id> decoded_hardware_ids;
 };
 
 /**
@@ -29,6 +31,90 @@ public:
  */
 using report = std::vector<manufacturer>;
 
+/**
+ * @class package_version
+ * @brief UTF-8 `[Version]` fields of an INF; see `version_info`.
+ */
+class package_version
+{
+public:
+    std::string class_name;
+    std::string provider;
+    std::string catalog_file;
+    std::string driver_date;
+    std::string driver_version;
+};
+
+/**
+ * @class parse_diagnostic
+ * @brief UTF-8 form of a `line_diagnostic` left by a lenient parse.
+ */
+class parse_diagnostic
+{
+public:
+    std::string section;
+    size_t line;
+    std::string reason;
+};
+
+/**
+ * @brief Convert the diagnostics of a lenient parse to UTF-8.
+ */
+std::vector<parse_diagnostic> to_parse_diagnostics(std::span<const line_diagnostic> diagnostics)
+{
+    std::vector<parse_diagnostic> result;
+    result.reserve(diagnostics.size());
+    for (const line_diagnostic& diagnostic : diagnostics)
+    {
+        result.push_back(parse_diagnostic{
+            .section = to_utf8(diagnostic.section),
+            .line = diagnostic.line,
+            .reason = std::string{ describe(diagnostic.reason) } });
+    }
+
+    return result;
+}
+
+/**
+ * @brief Convert `[Version]` fields to UTF-8.
+ */
+package_version to_package_version(const version_info& version)
+{
+    return package_version{
+        .class_name = to_utf8(version.class_name),
+        .provider = to_utf8(version.provider),
+        .catalog_file = to_utf8(version.catalog_file),
+        .driver_date = to_utf8(version.driver_date),
+        .driver_version = to_utf8(version.driver_version) };
+}
+
+/**
+ * @class package_triage
+ * @brief UTF-8 `triage_info` of an INF.
+ */
+class package_triage
+{
+public:
+    package_version version;
+    std::string class_guid;
+    bool has_manufacturer;
+};
+
+/**
+ * @brief Classify an INF from its `[Version]` keys and the existence of
+ *        `[Manufacturer]`; see `extract_triage_info`.
+ * @throws std::exception on Win32 failures.
+ */
+template <typename inf_source>
+package_triage select_triage_data(const inf_source& inf)
+{
+    const triage_info triage = extract_triage_info(inf);
+    return package_triage{
+        .version = to_package_version(triage.version),
+        .class_guid = to_utf8(triage.class_guid),
+        .has_manufacturer = triage.has_manufacturer };
+}
+
 /**
  * @class models_sections_correlation
  * @brief Internal helper that ties a resolved models section to the
@@ -46,7 +132,8 @@ public:
  * @brief Produce all existing models-section names for a manufacturer.
  *
  * The function yields the base section if present, and then for each
- * architecture qualifier, yields `base.arch` if such a section exists.
+ * architecture qualifier, yields `base.arch` if such a section exists and
+ * was not yielded already.
  *
  * @return `std::generator` yielding correlations lazily.
  */
@@ -56,9 +143,14 @@ std::generator<models_sections_correlation> correlate_models_sections(
 {
     static constexpr wchar_t delimiter = '.';
 
+    // repeated or case-variant decorations resolve to a section already
+    // yielded; parsing it again would make the report quadratic in them
+    std::unordered_set<const section_name*> yielded;
+
     if (std::unordered_set<section_name>::const_iterator section = all_sections.find(manufacturer.models_section_name)
         ; section != all_sections.end())
     {
+        yielded.insert(&*section);
         co_yield models_sections_correlation{ .architecture{}, .models_section{ *section} };
     }
 
@@ -75,7 +167,7 @@ std::generator<models_sections_correlation> correlate_models_sections(
             section = all_sections.find(composed);
         }
 
-        if (section != all_sections.end())
+        if (section != all_sections.end() && yielded.insert(&*section).second)
         {
             co_yield models_sections_correlation{ .architecture { architecture }, .models_section{ *section} };
         }
@@ -85,21 +177,36 @@ std::generator<models_sections_correlation> correlate_models_sections(
 /**
  * @class model_key
  * @brief Key used to deduplicate models across multiple sections: a pair of
- *        (description, list of hardware IDs). Case-insensitive comparison is
- *        used for the description via `key_name`.
+ *        (description, list of hardware IDs), both compared
+ *        case-insensitively.
+ *
+ * `hash` combines the description hash with the stored hardware-ID hashes
+ * and is computed once by `make_model_key`.
  */
 class model_key
 {
 public:
     key_name description;
-    std::vector<std::wstring> hardware_ids;
+    std::vector<hardware_id> hardware_ids;
+    std::uint64_t hash;
 };
 
 /**
- * @brief Hash functor for `model_key`.
- *
- * Combines a hash of the case-insensitive description with hashes of all
- * hardware IDs. Order-sensitive.
+ * @brief Build a `model_key` and its combined, order-sensitive hash.
+ */
+model_key make_model_key(key_name description, std::vector<hardware_id> hardware_ids)
+{
+    std::uint64_t hash = std::hash<key_name>{}(description);
+    for (const hardware_id& id : hardware_ids)
+    {
+        hash = combine_hash(hash, id.folded_hash);
+    }
+
+    return model_key{ .description = std::move(description), .hardware_ids = std::move(hardware_ids), .hash = hash };
+}
+
+/**
+ * @brief Hash functor for `model_key`: the precomputed hash.
  */
 template <>
 class std::hash<model_key>
@@ -107,27 +214,157 @@ class std::hash<model_key>
 public:
     size_t operator()(const model_key& key) const noexcept
     {
-        size_t result{ std::hash<key_name>{}(key.description) };
-        std::hash<std::wstring> hasher;
-        for (const auto& id : key.hardware_ids)
-        {
-            result = result * 131 + hasher(id);
-        }
-
-        return result;
+        return static_cast<size_t>(key.hash);
     }
 };
 
 /**
  * @brief Equality for `model_key` — description and the ordered list of
- *        hardware IDs must match.
+ *        hardware IDs must match. Keys with different hashes are rejected
+ *        by integer comparison.
  */
 bool operator==(const model_key& left, const model_key& right) noexcept
 {
-    return left.description == right.description
+    return left.hash == right.hash
+        && left.description == right.description
         && std::ranges::equal(left.hardware_ids, right.hardware_ids);
 }
 
+/**
+ * @typedef model_architectures
+ * @brief Models of one manufacturer grouped by key, with the architectures
+ *        of the models sections listing them.
+ */
+using model_architectures = std::unordered_map<model_key, std::vector<std::wstring>>;
+
+/**
+ * @brief Group the devices of one models section into `model_data`.
+ */
+void add_models(
+    model_architectures& model_data,
+    std::vector<device_description_line>&& devices,
+    std::wstring_view architecture)
+{
+    for (auto&& inf_device : devices)
+    {
+        model_key key = make_model_key(std::move(inf_device.device_description), std::move(inf_device.hardware_ids));
+
+        if (auto found = model_data.find(key)
+            ; found != model_data.end())
+        {
+            auto& architectures = found->second;
+            architectures.emplace_back(architecture);
+        }
+        else
+        {
+            model_data.insert(
+                std::pair{
+                    std::move(key),
+                    std::vector{ std::wstring{architecture} } });
+        }
+    }
+}
+
+/**
+ * @brief Convert the grouped models of a manufacturer to its UTF-8 report
+ *        entry.
+ */
+manufacturer make_manufacturer_data(const manufacturer_line& inf_manufacturer, const model_architectures& model_data)
+{
+    manufacturer report_entry{ .name = to_utf8(inf_manufacturer.name) };
+    report_entry.devices.reserve(model_data.size());
+    for (const auto& [key, architectures] : model_data)
+    {
+        model model{ .description = to_utf8(key.description) };
+
+        model.hardware_ids.reserve(key.hardware_ids.size());
+        for (const hardware_id& id : key.hardware_ids)
+        {
+            model.hardware_ids.push_back(to_utf8(id.text));
+        }
+
+        model.architectures.reserve(architectures.size());
+        for (const std::wstring& architecture : architectures)
+        {
+            model.architectures.push_back(to_utf8(architecture));
+        }
+
+        model.decoded_hardware_ids = decode_hardware_ids(model.hardware_ids);
+
+        report_entry.devices.push_back(std::move(model));
+    }
+
+    return report_entry;
+}
+
+/**
+ * @brief Build the report entry of one manufacturer.
+ *
+ * Parses the devices of every models section that exists for the
+ * manufacturer, groups them by description and hardware_ids gathering the
+ * architectures where they appear, and converts everything to UTF-8.
+ *
+ * @throws std::exception on Win32 or parsing failures.
+ */
+template <typename inf_source>
+manufacturer select_manufacturer_data(
+    const inf_source& inf,
+    const manufacturer_line& inf_manufacturer,
+    const std::unordered_set<section_name>& all_sections,
+    std::stop_token stop = {})
+{
+    model_architectures model_data{};
+    for (models_sections_correlation correlation : correlate_models_sections(inf_manufacturer, all_sections))
+    {
+        add_models(
+            model_data,
+            extract_device_descriptions(inf, correlation.models_section, stop),
+            correlation.architecture);
+    }
+
+    return make_manufacturer_data(inf_manufacturer, model_data);
+}
+
+/**
+ * @brief Lenient `select_manufacturer_data`: malformed device lines are
+ *        recorded in `diagnostics` and skipped.
+ * @return The report entry, or the error of a models section that cannot
+ *         be enumerated.
+ */
+template <typename inf_source>
+std::expected<manufacturer, inf_error> try_select_manufacturer_data(
+    const inf_source& inf,
+    const manufacturer_line& inf_manufacturer,
+    const std::unordered_set<section_name>& all_sections,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    model_architectures model_data{};
+    for (models_sections_correlation correlation : correlate_models_sections(inf_manufacturer, all_sections))
+    {
+        std::expected<std::vector<device_description_line>, inf_error> devices =
+            try_extract_device_descriptions(inf, correlation.models_section, diagnostics, stop);
+        if (!devices.has_value())
+        {
+            return std::unexpected{ devices.error() };
+        }
+
+        add_models(model_data, std::move(*devices), correlation.architecture);
+    }
+
+    return make_manufacturer_data(inf_manufacturer, model_data);
+}
+
+/**
+ * @brief Extract the `[Version]` fields of an INF as UTF-8.
+ * @throws std::exception on Win32 or parsing failures.
+ */
+template <typename inf_source>
+package_version select_version_data(const inf_source& inf, std::stop_token stop = {})
+{
+    return to_package_version(extract_version_info(inf, extract_sections(inf, stop), stop));
+}
+
 /**
  * @brief Build the final JSON-ready report from an INF file.
  *
@@ -140,60 +377,84 @@ bool operator==(const model_key& left, const model_key& right) noexcept
  *     architectures where they appear.
  *  6. Convert everything to UTF-8 and produce a `report`.
  *
+ * Steps 3 to 6 are done per manufacturer by `select_manufacturer_data`.
+ *
+ * `stop` is checked before every section and line read, so a cancelled
+ * parse ends within one line.
+ *
+ * @throws operation_cancelled once `stop` is signalled.
  * @throws std::exception on Win32 or parsing failures.
  */
-report select_report_data(const inf_file& inf)
+template <typename inf_source>
+report select_report_data(const inf_source& inf, std::stop_token stop = {})
 {
     report output;
 
-    const std::unordered_set<section_name> all_sections = extract_sections(inf);
-    for (auto& inf_manufacturer : extract_manufacturers(inf))
+    const std::unordered_set<section_name> all_sections = extract_sections(inf, stop);
+    for (auto& inf_manufacturer : extract_manufacturers(inf, stop))
     {
-        std::unordered_map<model_key, std::vector<std::wstring>> model_data{};
-        for (models_sections_correlation correlation : correlate_models_sections(inf_manufacturer, all_sections))
-        {
-            for (auto&& inf_device : extract_device_descriptions(inf, correlation.models_section))
-            {
-                model_key key{ .description = std::move(inf_device.device_description), .hardware_ids = std::move(inf_device.hardware_ids) };
-
-                if (auto found = model_data.find(key)
-                    ; found != model_data.end())
-                {
-                    auto& architectures = found->second;
-                    architectures.emplace_back(correlation.architecture);
-                }
-                else
-                {
-                    model_data.insert(
-                        std::pair{
-                            std::move(key),
-                            std::vector{ std::wstring{correlation.architecture} } });
-                }
-            }
-        }
+        output.emplace_back(select_manufacturer_data(inf, inf_manufacturer, all_sections, stop));
+    }
 
-        manufacturer report_entry{ .name = to_utf8(inf_manufacturer.name) };
-        report_entry.devices.reserve(model_data.size());
-        for (const auto& [key, architectures] : model_data)
-        {
-            model model{ .description = to_utf8(key.description) };
+    return output;
+}
 
-            model.hardware_ids.reserve(key.hardware_ids.size());
-            for (const std::wstring& hardware_id : key.hardware_ids)
+/**
+ * @brief Lenient `select_version_data`: unreadable `[Version]` lines are
+ *        recorded in `diagnostics` and skipped.
+ */
+template <typename inf_source>
+std::expected<package_version, inf_error> try_select_version_data(
+    const inf_source& inf,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    return try_extract_sections(inf, stop)
+        .and_then([&](const std::unordered_set<section_name>& all_sections)
             {
-                model.hardware_ids.push_back(to_utf8(hardware_id));
-            }
+                return try_extract_version_info(inf, all_sections, diagnostics, stop);
+            })
+        .transform(to_package_version);
+}
 
-            model.architectures.reserve(architectures.size());
-            for (const std::wstring& architecture : architectures)
-            {
-                model.architectures.push_back(to_utf8(architecture));
-            }
+/**
+ * @brief Lenient `select_report_data`: lines that cannot be read or are
+ *        malformed are recorded in `diagnostics` and skipped, and the rest
+ *        of the file is still reported. No exception is thrown for INF
+ *        errors; only the failure of a whole enumeration, such as a missing
+ *        `[Manufacturer]` section, is returned as an error.
+ *
+ * @throws operation_cancelled once `stop` is signalled.
+ */
+template <typename inf_source>
+std::expected<report, inf_error> try_select_report_data(
+    const inf_source& inf,
+    std::vector<line_diagnostic>& diagnostics,
+    std::stop_token stop = {})
+{
+    std::expected<std::unordered_set<section_name>, inf_error> all_sections = try_extract_sections(inf, stop);
+    if (!all_sections.has_value())
+    {
+        return std::unexpected{ all_sections.error() };
+    }
+
+    std::expected<std::vector<manufacturer_line>, inf_error> manufacturers = try_extract_manufacturers(inf, diagnostics, stop);
+    if (!manufacturers.has_value())
+    {
+        return std::unexpected{ manufacturers.error() };
+    }
 
-            report_entry.devices.push_back(std::move(model));
+    report output;
+    for (const manufacturer_line& inf_manufacturer : *manufacturers)
+    {
+        std::expected<manufacturer, inf_error> report_entry =
+            try_select_manufacturer_data(inf, inf_manufacturer, *all_sections, diagnostics, stop);
+        if (!report_entry.has_value())
+        {
+            return std::unexpected{ report_entry.error() };
         }
 
-        output.emplace_back(std::move(report_entry));
+        output.push_back(std::move(*report_entry));
     }
 
     return output;
@@ -17,17 +17,29 @@
 
 module;
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <expected>
 #include <filesystem>
+#include <functional>
 #include <stdexcept>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <optional>
+#include <span>
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <windows.h>
 #include <setupapi.h>
+#include <intrin.h>
 #undef WIN32_LEAN_AND_MEAN
 #undef NOMINMAX
 
@@ -192,15 +204,128 @@ public:
         return std::char_traits<wchar_t>::not_eof(value);
     }
 
+    /**
+     * @brief Case-insensitive hash, consistent with `eq`.
+     *
+     * Characters are folded and mixed four at a time (one 64-bit word),
+     * wyhash-style: two words per 128-bit multiply. Words of ASCII characters,
+     * nearly every section name, key and hardware ID, are lowered with SWAR
+     * arithmetic; other characters go through `CharLowerW`.
+     */
     template <typename range>
-    static size_t hash(const range& string)
+    static size_t hash(const range& string) noexcept
     {
-        size_t result{ 0 };
-        for (wchar_t ch : string)
+        static constexpr size_t word_characters = sizeof(std::uint64_t) / sizeof(wchar_t);
+
+        const wchar_t* data = string.data();
+        const size_t count = string.size();
+
+        std::uint64_t seed = hash_secret[0] ^ count;
+        size_t position{ 0 };
+        for (; position + 2 * word_characters <= count; position += 2 * word_characters)
+        {
+            seed = multiply_mix(
+                fold_word(load_word(data + position, word_characters)) ^ hash_secret[1],
+                fold_word(load_word(data + position + word_characters, word_characters)) ^ seed);
+        }
+
+        const size_t remaining = count - position;
+        const size_t first_part = std::min(remaining, word_characters);
+        seed = multiply_mix(
+            fold_word(load_word(data + position, first_part)) ^ hash_secret[1],
+            fold_word(load_word(data + position + first_part, remaining - first_part)) ^ seed);
+
+        return static_cast<size_t>(multiply_mix(seed ^ hash_secret[2], count ^ hash_secret[3]));
+    }
+
+private:
+    static_assert(sizeof(wchar_t) == sizeof(std::uint16_t), "UTF-16 wchar_t is expected");
+
+    static constexpr std::uint64_t hash_secret[]{
+        0xA0761D6478BD642Full,
+        0xE7037ED1A0B428DBull,
+        0x8EBC6AF09C88C6E3ull,
+        0x589965CC75374CC3ull };
+
+    /**
+     * @brief Fold the 128-bit product of two words to 64 bits.
+     */
+    static std::uint64_t multiply_mix(std::uint64_t left, std::uint64_t right) noexcept
+    {
+#if defined(_M_X64)
+        std::uint64_t high;
+        const std::uint64_t low = _umul128(left, right, &high);
+        return low ^ high;
+#elif defined(_M_ARM64)
+        return (left * right) ^ __umulh(left, right);
+#else
+        const std::uint64_t left_low = left & 0xFFFFFFFFull;
+        const std::uint64_t left_high = left >> 32;
+        const std::uint64_t right_low = right & 0xFFFFFFFFull;
+        const std::uint64_t right_high = right >> 32;
+
+        const std::uint64_t low_low = left_low * right_low;
+        const std::uint64_t high_low = left_high * right_low;
+        const std::uint64_t low_high = left_low * right_high;
+        const std::uint64_t high_high = left_high * right_high;
+
+        const std::uint64_t middle = (low_low >> 32) + (high_low & 0xFFFFFFFFull) + low_high;
+        const std::uint64_t low = (middle << 32) | (low_low & 0xFFFFFFFFull);
+        const std::uint64_t high = high_high + (high_low >> 32) + (middle >> 32);
+        return low ^ high;
+#endif
+    }
+
+    /**
+     * @brief Load up to four characters into a word, zero-padded.
+     */
+    static std::uint64_t load_word(const wchar_t* characters, size_t count) noexcept
+    {
+        std::uint64_t word{ 0 };
+        if (count != 0)
+        {
+            std::memcpy(&word, characters, count * sizeof(wchar_t));
+        }
+
+        return word;
+    }
+
+    /**
+     * @brief Lower-case the four UTF-16 characters of a word.
+     */
+    static std::uint64_t fold_word(std::uint64_t word) noexcept
+    {
+        static constexpr std::uint64_t lanes = 0x0001000100010001ull;
+        static constexpr std::uint64_t non_ascii = 0xFF80 * lanes;
+        static constexpr std::uint64_t lane_top = 0x0080 * lanes;
+
+        if ((word & non_ascii) == 0)
+        {
+            // every lane is below 0x80, so adding to a lane never carries
+            // into the next one; bit 7 tells whether the lane reached the
+            // bound
+            const std::uint64_t at_least_a = word + (0x80 - 'A') * lanes;
+            const std::uint64_t beyond_z = word + (0x80 - 'Z' - 1) * lanes;
+            const std::uint64_t upper = at_least_a & ~beyond_z & lane_top;
+            return word | (upper >> 2);
+        }
+
+        std::uint64_t result{ 0 };
+        for (int shift = 0; shift < 64; shift += 16)
         {
-            // simple prime-based hash
-            result = result * 131 + char_lower(ch);
+            wchar_t value = static_cast<wchar_t>((word >> shift) & 0xFFFF);
+            if (value < 0x80)
+            {
+                value = value >= L'A' && value <= L'Z' ? static_cast<wchar_t>(value - L'A' + L'a') : value;
+            }
+            else
+            {
+                value = char_lower(value);
+            }
+
+            result |= std::uint64_t{ static_cast<std::uint16_t>(value) } << shift;
         }
+
         return result;
     }
 };
@@ -274,6 +399,98 @@ export using key_name = std::basic_string<
  */
 export using key_name_view = std::basic_string_view<wchar_t, winapi_case_insensitive_wchar_traits>;
 
+/**
+ * @enum inf_error
+ * @brief Reasons an INF read can fail, for the `try_*` functions that
+ *        return `std::expected` instead of throwing.
+ */
+export enum class inf_error
+{
+    section_enumeration_failed,
+    section_name_failed,
+    section_not_found,
+    first_line_failed,
+    next_line_failed,
+    field_count_failed,
+    field_length_failed,
+    field_read_failed,
+    field_out_of_range,
+    missing_install_section
+};
+
+/**
+ * @brief Message of an `inf_error`, as thrown by the throwing functions.
+ */
+export constexpr std::string_view describe(inf_error error) noexcept
+{
+    switch (error)
+    {
+    case inf_error::section_enumeration_failed:
+        return "Failed to enumerate INF sections";
+
+    case inf_error::section_name_failed:
+        return "Failed to retrieve an INF section name";
+
+    case inf_error::section_not_found:
+        return "Could not find the specified INF section";
+
+    case inf_error::first_line_failed:
+        return "Fatal error while retrieving the first line of an INF section";
+
+    case inf_error::next_line_failed:
+        return "Fatal error while retrieving a next line of an INF section";
+
+    case inf_error::field_count_failed:
+        return "Failed to retrieve field count";
+
+    case inf_error::field_length_failed:
+        return "Failed to determine a string field length";
+
+    case inf_error::field_read_failed:
+        return "Failed to retrieve a string field";
+
+    case inf_error::field_out_of_range:
+        return "INF field index out of range";
+
+    case inf_error::missing_install_section:
+        return "install-section-name field is missing";
+    }
+
+    return "Unexpected INF error";
+}
+
+/**
+ * @brief Throw the exception the throwing functions raise for an error:
+ *        `std::out_of_range` for bad field indices, `std::runtime_error`
+ *        otherwise.
+ */
+export [[noreturn]] void throw_inf_error(inf_error error)
+{
+    if (error == inf_error::field_out_of_range)
+    {
+        throw std::out_of_range(std::string{ describe(error) });
+    }
+
+    throw std::runtime_error(std::string{ describe(error) });
+}
+
+/**
+ * @brief Unwrap an expected INF read, throwing its error.
+ */
+export template <typename T>
+T value_or_throw(std::expected<T, inf_error>&& result)
+{
+    if (!result.has_value())
+    {
+        throw_inf_error(result.error());
+    }
+
+    if constexpr (!std::is_void_v<T>)
+    {
+        return std::move(*result);
+    }
+}
+
 /**
  * @class section_search
  * @brief Enumerator over all section names in an opened INF file.
@@ -296,7 +513,7 @@ private:
     section_name buffer;
     bool done;
 
-    void update_state()
+    std::expected<void, inf_error> try_update_state()
     {
         UINT size_needed;
         BOOL found = SetupEnumInfSectionsW(
@@ -318,7 +535,7 @@ private:
 
             if (found == FALSE)
             {
-                throw std::runtime_error("Failed to retrieve an INF section name");
+                return std::unexpected{ inf_error::section_name_failed };
             }
 
             buffer.resize(size_needed - 1);
@@ -329,8 +546,10 @@ private:
         }
         else
         {
-            throw std::runtime_error("Failed to enumerate INF sections");
+            return std::unexpected{ inf_error::section_enumeration_failed };
         }
+
+        return {};
     }
 
 public:
@@ -342,13 +561,23 @@ public:
     {
     }
 
-    bool move_next()
+    std::expected<bool, inf_error> try_move_next()
     {
-        update_state();
+        std::expected<void, inf_error> updated = try_update_state();
         ++next_index;
+        if (!updated.has_value())
+        {
+            return std::unexpected{ updated.error() };
+        }
+
         return !done;
     }
 
+    bool move_next()
+    {
+        return value_or_throw(try_move_next());
+    }
+
     bool has_value() const noexcept
     {
         return next_index != 0 && !done;
@@ -375,6 +604,19 @@ public:
  *               reported via `SetupGetFieldCount`.
  *  - `field_at(i)` — 0-based accessor to value fields. Uses
  *                    `SetupGetStringFieldW` and throws on failure.
+ *  - `fields()` — every value field at once, read with one
+ *    `SetupGetMultiSzFieldW` call into a buffer kept across lines.
+ *    `append_fields(target, first)` appends them, from `first` on, to any
+ *    container with `emplace_back`.
+ *  - `try_key()`, `try_size()`, `try_field_at(i)`, `try_fields()`,
+ *    `try_append_fields(target, first)` — the same, returning `inf_error`
+ *    through `std::expected` instead of throwing.
+ *
+ * Nothing is read until it is asked for: the key, the count and each field
+ * are fetched on first access and cached. Enumerations reuse one `line` as
+ * a cursor: moving it to the next line bumps `generation`, which
+ * invalidates every cache without releasing its buffer. Returned views stay
+ * valid until the line moves on.
  *
  * @note Values are returned exactly as SetupAPI expands them; %strkeys% are
  *       already substituted.
@@ -384,13 +626,32 @@ public:
 export class line
 {
 private:
+    /**
+     * @class cached
+     * @brief A fetched value and the generation it was fetched for; 0 is
+     *        never a line's generation.
+     */
+    template <typename T>
+    class cached
+    {
+    public:
+        T value{};
+        std::uint64_t generation{ 0 };
+    };
+
     mutable INFCONTEXT context;
-    key_name key_buffer;
-    mutable std::optional<DWORD> count; // lazily initialized
-    mutable std::wstring field_buffer;
+    std::uint64_t generation;
+    mutable cached<key_name> key_cache;
+    mutable cached<DWORD> count_cache;
+    mutable std::vector<cached<std::wstring>> field_cache;
+    mutable cached<std::vector<std::wstring_view>> fields_cache;
+    mutable std::wstring multi_sz_buffer;
 
     template <typename char_traits>
-    void get_field(DWORD field, std::basic_string<wchar_t, char_traits, std::allocator<wchar_t>>& target) const
+    static std::expected<void, inf_error> try_get_field(
+        INFCONTEXT& context,
+        DWORD field,
+        std::basic_string<wchar_t, char_traits, std::allocator<wchar_t>>& target)
     {
         DWORD target_size;
         if (SetupGetStringFieldW(
@@ -401,7 +662,7 @@ private:
                 &target_size)
             == FALSE)
         {
-            throw std::runtime_error("Failed to determine a string field length");
+            return std::unexpected{ inf_error::field_length_failed };
         }
 
         target.resize(target_size);
@@ -413,63 +674,254 @@ private:
                 NULL)
             == FALSE)
         {
-            throw std::runtime_error("Failed to retrieve a string field");
+            return std::unexpected{ inf_error::field_read_failed };
         }
 
         target.resize(target_size - 1);
+        return {};
     }
 
-    constexpr static DWORD key_index{0};
+    constexpr static DWORD key_field{0};
 
-    explicit line(const INFCONTEXT& context)
-        : context{context},
-        key_buffer{},
-        count{ std::nullopt },
-        field_buffer{}
+    explicit line(const INFCONTEXT& context) noexcept
+        : context{ context },
+        generation{ 1 },
+        key_cache{},
+        count_cache{},
+        field_cache{},
+        fields_cache{},
+        multi_sz_buffer{}
     {
-        get_field(key_index, key_buffer);
+    }
+
+    line(const INFCONTEXT& context, key_name&& key) noexcept
+        : line{ context }
+    {
+        key_cache = cached<key_name>{ .value = std::move(key), .generation = generation };
+    }
+
+    /**
+     * @brief Point the cursor at another line, dropping every cached value.
+     */
+    void move_to(const INFCONTEXT& next) noexcept
+    {
+        context = next;
+        ++generation;
+    }
+
+    /**
+     * @brief Read the value fields as a multi-sz list into `multi_sz_buffer`,
+     *        growing it only when a line does not fit.
+     * @return Whether SetupAPI returned the list.
+     */
+    bool read_multi_sz() const
+    {
+        static constexpr size_t initial_size{ 256 };
+
+        if (multi_sz_buffer.empty())
+        {
+            multi_sz_buffer.resize(initial_size);
+        }
+
+        DWORD required{ 0 };
+        if (SetupGetMultiSzFieldW(
+                &context,
+                1,
+                multi_sz_buffer.data(),
+                static_cast<DWORD>(multi_sz_buffer.size()),
+                &required)
+            == TRUE)
+        {
+            return true;
+        }
+
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || required <= multi_sz_buffer.size())
+        {
+            return false;
+        }
+
+        multi_sz_buffer.resize(required);
+        return SetupGetMultiSzFieldW(
+                &context,
+                1,
+                multi_sz_buffer.data(),
+                required,
+                NULL)
+            == TRUE;
     }
 
     friend class inf_file;
     friend class line_search;
+    friend class key_index;
 public:
 
-    key_name_view key() const noexcept
+    std::expected<key_name_view, inf_error> try_key() const
     {
-        return key_buffer;
+        if (key_cache.generation != generation)
+        {
+            if (std::expected<void, inf_error> read = try_get_field(context, key_field, key_cache.value)
+                ; !read.has_value())
+            {
+                return std::unexpected{ read.error() };
+            }
+
+            key_cache.generation = generation;
+        }
+
+        return key_name_view{ key_cache.value };
     }
 
-    size_t size() const
+    key_name_view key() const
     {
-        if (!count.has_value())
+        return value_or_throw(try_key());
+    }
+
+    std::expected<size_t, inf_error> try_size() const
+    {
+        if (count_cache.generation != generation)
         {
             SetLastError(NO_ERROR);
             DWORD field_count = SetupGetFieldCount(&context);
             if (field_count == 0 && GetLastError() != NO_ERROR)
             {
-                throw std::runtime_error("Failed to retrieve field count");
+                return std::unexpected{ inf_error::field_count_failed };
             }
 
-            count = field_count;
+            count_cache = cached<DWORD>{ .value = field_count, .generation = generation };
         }
 
-        return *count;
+        return count_cache.value;
     }
 
-    std::wstring_view field_at(ptrdiff_t index) const
+    size_t size() const
+    {
+        return value_or_throw(try_size());
+    }
+
+    std::expected<std::wstring_view, inf_error> try_field_at(ptrdiff_t index) const
     {
+        std::expected<size_t, inf_error> fields = try_size();
+        if (!fields.has_value())
+        {
+            return std::unexpected{ fields.error() };
+        }
+
         if (index < 0
-            || static_cast<size_t>(index) >= size()
+            || static_cast<size_t>(index) >= *fields
             || index > std::numeric_limits<DWORD>::max() - 1)
         {
-            throw std::out_of_range("INF field index out of range");
+            return std::unexpected{ inf_error::field_out_of_range };
+        }
+
+        // sized once per line, so views of fetched fields are not moved by
+        // a later access
+        if (field_cache.size() < *fields)
+        {
+            field_cache.resize(*fields);
+        }
+
+        cached<std::wstring>& field = field_cache[static_cast<size_t>(index)];
+        if (field.generation != generation)
+        {
+            if (std::expected<void, inf_error> read = try_get_field(
+                    context,
+                    static_cast<DWORD>(index) + 1, // INF fields indexes are 1-based
+                    field.value)
+                ; !read.has_value())
+            {
+                return std::unexpected{ read.error() };
+            }
+
+            field.generation = generation;
+        }
+
+        return std::wstring_view{ field.value };
+    }
+
+    std::wstring_view field_at(ptrdiff_t index) const
+    {
+        return value_or_throw(try_field_at(index));
+    }
+
+    std::expected<std::span<const std::wstring_view>, inf_error> try_fields() const
+    {
+        if (fields_cache.generation == generation)
+        {
+            return fields_cache.value;
+        }
+
+        std::expected<size_t, inf_error> count = try_size();
+        if (!count.has_value())
+        {
+            return std::unexpected{ count.error() };
+        }
+
+        std::vector<std::wstring_view>& views = fields_cache.value;
+        views.clear();
+        if (*count != 0 && read_multi_sz())
+        {
+            const wchar_t* position = multi_sz_buffer.data();
+            const wchar_t* const end = position + multi_sz_buffer.size();
+            while (position != end && *position != L'\0' && views.size() < *count)
+            {
+                const wchar_t* terminator = std::char_traits<wchar_t>::find(position, end - position, L'\0');
+                if (terminator == nullptr)
+                {
+                    break;
+                }
+
+                views.emplace_back(position, terminator);
+                position = terminator + 1;
+            }
+        }
+
+        // an empty field ends a multi-sz list early, so a short list is
+        // read again field by field
+        if (views.size() != *count)
+        {
+            views.clear();
+            for (size_t index = 0; index < *count; ++index)
+            {
+                std::expected<std::wstring_view, inf_error> field = try_field_at(static_cast<ptrdiff_t>(index));
+                if (!field.has_value())
+                {
+                    return std::unexpected{ field.error() };
+                }
+
+                views.push_back(*field);
+            }
+        }
+
+        fields_cache.generation = generation;
+        return views;
+    }
+
+    std::span<const std::wstring_view> fields() const
+    {
+        return value_or_throw(try_fields());
+    }
+
+    template <typename container>
+    std::expected<void, inf_error> try_append_fields(container& target, size_t first = 0) const
+    {
+        std::expected<std::span<const std::wstring_view>, inf_error> values = try_fields();
+        if (!values.has_value())
+        {
+            return std::unexpected{ values.error() };
         }
 
-        get_field(
-            static_cast<DWORD>(index) + 1, // INF fields indexes are 1-based
-            field_buffer);
+        for (size_t index = first; index < values->size(); ++index)
+        {
+            target.emplace_back((*values)[index]);
+        }
 
-        return field_buffer;
+        return {};
+    }
+
+    template <typename container>
+    void append_fields(container& target, size_t first = 0) const
+    {
+        value_or_throw(try_append_fields(target, first));
     }
 };
 
@@ -478,7 +930,8 @@ public:
  * @brief Linear enumerator across all lines within a given section.
  *
  * Implements the usual `move_next()` + `current_line()` pattern on top of
- * `SetupFindFirstLineW` / `SetupFindNextLine`.
+ * `SetupFindFirstLineW` / `SetupFindNextLine`. `current_line()` is one
+ * `line` moved along the section, not a new object per line.
  *
  * @throws std::runtime_error on Win32 failures; throws `std::logic_error` if
  *         misused (e.g., reading after end).
@@ -497,17 +950,19 @@ private:
     section_name_view section;
     INFCONTEXT context;
     position current;
+    line cursor;
 
 public:
     line_search(HINF file, section_name_view section)
         : file{ file },
         section{ section },
         context{},
-        current{position::start}
+        current{position::start},
+        cursor{ INFCONTEXT{} }
     {
     }
 
-    bool move_next()
+    std::expected<bool, inf_error> try_move_next()
     {
         switch (current)
         {
@@ -523,14 +978,14 @@ public:
                 switch (GetLastError())
                 {
                 case ERROR_SECTION_NOT_FOUND:
-                    throw std::runtime_error("Could not find the specified INF section");
+                    return std::unexpected{ inf_error::section_not_found };
 
                 case ERROR_LINE_NOT_FOUND:
                     current = position::end;
                     return false;
 
                 default:
-                    throw std::runtime_error("Fatal error while retrieving the first line of an INF section");
+                    return std::unexpected{ inf_error::first_line_failed };
                 }
             }
             else
@@ -552,7 +1007,7 @@ public:
                 }
                 else
                 {
-                    throw std::runtime_error("Fatal error while retrieving a next line of an INF section");
+                    return std::unexpected{ inf_error::next_line_failed };
                 }
             }
         }
@@ -565,22 +1020,133 @@ public:
             throw std::logic_error("Unexpected position value");
         }
 
+        cursor.move_to(context);
         return true;
     }
 
+    bool move_next()
+    {
+        return value_or_throw(try_move_next());
+    }
+
     bool has_line() const noexcept
     {
         return current == position::middle;
     }
 
-    line current_line() const
+    const line& current_line() const
     {
         if (!has_line())
         {
             throw std::logic_error("INF line enumeration either not started or already finished");
         }
 
-        return line(context);
+        return cursor;
+    }
+};
+
+/**
+ * @class key_index
+ * @brief Case-insensitive key lookup table of one INF section, built by a
+ *        single enumeration of its lines.
+ *
+ * Flat open addressing with linear probing: `slots` has a power-of-two
+ * size of at least twice the line count and holds 1-based positions into
+ * `entries`, 0 marking an empty slot. An entry keeps the first line of its
+ * key, which is the line `SetupFindFirstLineW` returns for that key, with
+ * its `INFCONTEXT` so a hit needs no further SetupAPI call. Keys are what
+ * `line::key()` returns; lines whose key cannot be read are left out, so
+ * one bad line does not fail lookups of the others.
+ *
+ * @throws std::runtime_error if the section does not exist or cannot be
+ *         enumerated.
+ */
+class key_index
+{
+public:
+    class entry
+    {
+    public:
+        key_name key;
+        size_t hash;
+        INFCONTEXT context;
+    };
+
+private:
+    std::vector<entry> entries;
+    std::vector<std::uint32_t> slots;
+
+    static size_t hash_key(key_name_view key) noexcept
+    {
+        return winapi_case_insensitive_wchar_traits::hash(key);
+    }
+
+    /**
+     * @brief Slot holding the key, or the empty slot ending its probe
+     *        sequence.
+     */
+    size_t probe(key_name_view key, size_t hash) const noexcept
+    {
+        const size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot] != 0)
+        {
+            const entry& candidate = entries[slots[slot] - 1];
+            if (candidate.hash == hash && candidate.key == key)
+            {
+                break;
+            }
+
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+public:
+    key_index(HINF file, section_name_view section)
+    {
+        const LONG count = SetupGetLineCountW(file, section.data());
+        if (count < 0)
+        {
+            throw_inf_error(inf_error::section_not_found);
+        }
+
+        entries.reserve(static_cast<size_t>(count));
+        slots.resize(std::bit_ceil(std::max<size_t>(2 * static_cast<size_t>(count), 8)));
+
+        line_search search(file, section);
+        while (search.move_next())
+        {
+            // a line whose key cannot be read is left out rather than
+            // failing lookups of every other key
+            const line& current = search.current_line();
+            const std::expected<key_name_view, inf_error> read = current.try_key();
+            if (!read.has_value())
+            {
+                continue;
+            }
+
+            const key_name_view key = *read;
+            const size_t hash = hash_key(key);
+            const size_t slot = probe(key, hash);
+            if (slots[slot] != 0)
+            {
+                continue;
+            }
+
+            entries.push_back(entry{
+                .key = key_name{ key },
+                .hash = hash,
+                .context = current.context });
+            slots[slot] = static_cast<std::uint32_t>(entries.size());
+        }
+    }
+
+    const entry* find(key_name_view key) const noexcept
+    {
+        const std::uint32_t position = slots[probe(key, hash_key(key))];
+        return position == 0 ? nullptr : &entries[position - 1];
     }
 };
 
@@ -594,6 +1160,19 @@ export enum class enumeration
     stop
 };
 
+/**
+ * @class operation_cancelled
+ * @brief Thrown by an enumeration whose stop token was signalled.
+ */
+export class operation_cancelled : public std::runtime_error
+{
+public:
+    operation_cancelled()
+        : std::runtime_error{ "INF parsing was cancelled" }
+    {
+    }
+};
+
 /**
  * @class inf_file
  * @brief RAII wrapper for an INF handle with high-level enumeration helpers.
@@ -602,9 +1181,25 @@ export enum class enumeration
  *  - Open/close the INF (`SetupOpenInfFileW` / `SetupCloseInfFile`).
  *  - `for_each_section(F)` — visits every section, stops early if the visitor
  *    returns `enumeration::stop`.
- *  - `for_each_line(section, F)` — visits each line within a section.
+ *  - `for_each_line(section, F)` — visits each line within a section. The
+ *    visitor gets the same `line` for every line, moved along the section;
+ *    it reads only what it uses and must not keep it past the call.
+ *  - Both enumerations take an optional `std::stop_token`, checked before
+ *    every item; a signalled token throws `operation_cancelled`. The
+ *    default token has no stop state, so the check is a null test.
+ *  - `try_for_each_section` / `try_for_each_line` — the same without
+ *    exceptions for INF errors: the visitor reads each line through its
+ *    `try_*` accessors, so a line that cannot be read does not end the
+ *    enumeration; a failure of the enumeration itself ends it and is
+ *    returned. Cancellation still throws.
  *  - `get_line(section, key)` — returns the first matching line or `nullopt` if
- *    the key is absent; throws if the section does not exist.
+ *    the key is absent; throws if the section does not exist. The first
+ *    lookup in a section indexes its keys (`key_index`); later lookups in
+ *    that section are constant-time. Sections never looked up by key are
+ *    not indexed. Like `line`, the cache is not synchronized: one
+ *    `inf_file` is not for concurrent use.
+ *  - `has_section(section)` — whether the section exists, without reading
+ *    its lines (`SetupGetLineCountW`).
  *
  * @throws std::runtime_error for Win32 failures.
  */
@@ -614,6 +1209,7 @@ private:
 
     static constexpr const HINF empty = INVALID_HANDLE_VALUE;
     HINF handle;
+    mutable std::unordered_map<section_name, key_index, std::hash<section_name>, std::equal_to<>> key_indexes;
 
 public:
 
@@ -639,6 +1235,7 @@ private:
             return;
         }
 
+        key_indexes.clear();
         SetupCloseInfFile(handle);
         handle = empty;
     }
@@ -650,7 +1247,8 @@ public:
             inf_path.native().c_str(),
             NULL,
             INF_STYLE_WIN4,
-            NULL)}
+            NULL)},
+        key_indexes{}
     {
         if (handle == empty) {
             throw std::runtime_error("Failed to open the requested INF file");
@@ -666,7 +1264,8 @@ public:
     inf_file& operator=(inf_file&) = delete;
 
     inf_file(inf_file&& other) noexcept
-    : handle { std::exchange(other.handle, empty) }
+    : handle { std::exchange(other.handle, empty) },
+        key_indexes{ std::move(other.key_indexes) }
     {
     }
 
@@ -679,19 +1278,25 @@ public:
 
         close();
         handle = std::exchange(other.handle, empty);
+        key_indexes = std::move(other.key_indexes);
 
         return *this;
     }
 
     template <typename F>
     requires std::is_invocable_r_v<enumeration, F, section_name_view>
-    void for_each_section(F&& section_name_handler) const
+    void for_each_section(F&& section_name_handler, std::stop_token stop = {}) const
     {
         ensure_open();
 
         section_search search(handle);
         while (search.move_next())
         {
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
             if (section_name_handler(search.value()) == enumeration::stop)
             {
                 return;
@@ -700,14 +1305,19 @@ public:
     }
 
     template <typename F>
-    requires std::is_invocable_r_v<enumeration, F, line&&>
-    void for_each_line(section_name_view section_name, F&& key_value_handler) const
+    requires std::is_invocable_r_v<enumeration, F, const line&>
+    void for_each_line(section_name_view section_name, F&& key_value_handler, std::stop_token stop = {}) const
     {
         ensure_open();
 
         line_search search(handle, section_name);
         while (search.move_next())
         {
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
             if (key_value_handler(search.current_line()) == enumeration::stop)
             {
                 return;
@@ -715,33 +1325,97 @@ public:
         }
     }
 
-    std::optional<line> get_line(section_name_view section, key_name_view key) const
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, section_name_view>
+    std::expected<void, inf_error> try_for_each_section(F&& section_name_handler, std::stop_token stop = {}) const
     {
         ensure_open();
 
-        INFCONTEXT context;
-        BOOL found = SetupFindFirstLineW(
-            handle,
-            section.data(),
-            key.data(),
-            &context);
+        section_search search(handle);
+        while (true)
+        {
+            std::expected<bool, inf_error> found = search.try_move_next();
+            if (!found.has_value())
+            {
+                return std::unexpected{ found.error() };
+            }
 
-        if (!found)
+            if (!*found)
+            {
+                return {};
+            }
+
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
+            if (section_name_handler(search.value()) == enumeration::stop)
+            {
+                return {};
+            }
+        }
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, const line&>
+    std::expected<void, inf_error> try_for_each_line(
+        section_name_view section_name,
+        F&& key_value_handler,
+        std::stop_token stop = {}) const
+    {
+        ensure_open();
+
+        line_search search(handle, section_name);
+        while (true)
         {
-            switch (GetLastError())
+            std::expected<bool, inf_error> found = search.try_move_next();
+            if (!found.has_value())
             {
-            case ERROR_SECTION_NOT_FOUND:
-                throw std::runtime_error("Could not find the specified INF section");
+                return std::unexpected{ found.error() };
+            }
+
+            if (!*found)
+            {
+                return {};
+            }
 
-            case ERROR_LINE_NOT_FOUND:
-                return std::nullopt;
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
 
-            default:
-                throw std::runtime_error("Fatal error while searching for a line of an INF section");
+            if (key_value_handler(search.current_line()) == enumeration::stop)
+            {
+                return {};
             }
         }
+    }
 
-        return line(context);
+    bool has_section(section_name_view section) const
+    {
+        ensure_open();
+
+        return SetupGetLineCountW(handle, section.data()) >= 0;
+    }
+
+    std::optional<line> get_line(section_name_view section, key_name_view key) const
+    {
+        ensure_open();
+
+        auto indexed = key_indexes.find(section);
+        if (indexed == key_indexes.end())
+        {
+            indexed = key_indexes.try_emplace(section_name{ section }, handle, section).first;
+        }
+
+        const key_index::entry* found = indexed->second.find(key);
+        if (found == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        return line{ found->context, key_name{ found->key } };
     }
 };
 
@@ -814,3 +1488,79 @@ std::string to_utf8(std::basic_string<wchar_t, traits, allocator> unicode)
     std::basic_string_view<wchar_t, traits> view{ unicode };
     return to_utf8(view);
 }
+
+/**
+ * @brief Convert UTF-8 text to UTF-16 using `MultiByteToWideChar`.
+ *
+ * @param utf8 Source UTF-8 string view.
+ * @return UTF-16 encoded `std::wstring`.
+ * @throws std::range_error if the input length exceeds Win32 conversion limits.
+ * @throws std::runtime_error on conversion failures, including malformed input.
+ */
+export std::wstring from_utf8(std::string_view utf8)
+{
+    if (utf8.empty())
+    {
+        return std::wstring{};
+    }
+
+    if (utf8.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+    {
+        throw std::range_error("Input too long for UTF-16 conversion");
+    }
+
+    int size_chars = MultiByteToWideChar(
+        CP_UTF8,
+        MB_ERR_INVALID_CHARS,
+        utf8.data(),
+        static_cast<int>(utf8.size()),
+        nullptr,
+        0);
+    if (size_chars == 0)
+    {
+        throw std::runtime_error("Failed to determine UTF-16 output size");
+    }
+
+    std::wstring result(size_chars, L'\0');
+
+    int actual_converted = MultiByteToWideChar(
+        CP_UTF8,
+        MB_ERR_INVALID_CHARS,
+        utf8.data(),
+        static_cast<int>(utf8.size()),
+        result.data(),
+        size_chars);
+    if (actual_converted == 0)
+    {
+        throw std::runtime_error("Failed to perform UTF-16 conversion");
+    }
+
+    result.resize(actual_converted);
+    return result;
+}
+
+/**
+ * @brief Fold text to lower case with the same Win32 rules the
+ *        case-insensitive traits use (`CharLowerBuffW`).
+ *
+ * Folded strings can be compared and sorted ordinally, which is what
+ * merge-based algorithms over identifiers need.
+ *
+ * @throws std::range_error if the input length exceeds Win32 limits.
+ */
+export template <typename traits>
+std::wstring fold_case(std::basic_string_view<wchar_t, traits> text)
+{
+    if (text.size() > static_cast<size_t>(std::numeric_limits<DWORD>::max()))
+    {
+        throw std::range_error("Input too long for case folding");
+    }
+
+    std::wstring result{ text.data(), text.size() };
+    if (!result.empty())
+    {
+        CharLowerBuffW(result.data(), static_cast<DWORD>(result.size()));
+    }
+
+    return result;
+}
@@ -0,0 +1,703 @@
+/**
+ * @file snapshot.h
+ * @brief Tokenized INF snapshots (`.infc`): the sections, lines and fields
+ *        SetupAPI produced for an INF, stored in a memory-mappable file.
+ *
+ * Layout (native little-endian, every table 4-byte aligned):
+ *
+ * ```
+ * snapshot_header
+ * snapshot_section[section_count]      in SetupAPI enumeration order
+ * uint32_t[section_count]              section indexes sorted by name
+ * snapshot_line_record[line_count]
+ * uint32_t[line_count]                 line indexes of each section's range
+ *                                      sorted by key, first line first
+ * uint32_t[field_count]                string index of each value field
+ * snapshot_string[string_count]        (offset, length) into the pool
+ * wchar_t[character_count]             string pool, %strkey% already expanded
+ * ```
+ *
+ * Opening validates the header and the total size only, then maps the
+ * file; indexes are bounds-checked on access. The header carries the
+ * SHA-256 of the source INF, and snapshots are named after it, so a changed
+ * source never loads a stale snapshot.
+ */
+
+static_assert(sizeof(wchar_t) == sizeof(std::uint16_t), "Snapshots store UTF-16 code units");
+
+/**
+ * @class snapshot_header
+ * @brief Fixed-size `.infc` header.
+ */
+class snapshot_header
+{
+public:
+    static constexpr std::array<char, 4> expected_magic{ 'I', 'N', 'F', 'C' };
+    static constexpr std::uint32_t current_version{ 2 };
+
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    sha256_digest source;
+    std::uint32_t section_count;
+    std::uint32_t line_count;
+    std::uint32_t field_count;
+    std::uint32_t string_count;
+    std::uint64_t character_count;
+};
+
+static_assert(sizeof(snapshot_header) == 64 && std::is_trivially_copyable_v<snapshot_header>);
+
+/**
+ * @class snapshot_section
+ * @brief Section directory entry: name and range of lines.
+ */
+class snapshot_section
+{
+public:
+    std::uint32_t name;
+    std::uint32_t first_line;
+    std::uint32_t line_count;
+};
+
+/**
+ * @class snapshot_line_record
+ * @brief Line table entry: key and range of value fields.
+ */
+class snapshot_line_record
+{
+public:
+    std::uint32_t key;
+    std::uint32_t first_field;
+    std::uint32_t field_count;
+};
+
+/**
+ * @class snapshot_string
+ * @brief String table entry: offset and length in UTF-16 code units.
+ */
+class snapshot_string
+{
+public:
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+/**
+ * @brief Narrow a table size or index to the 32-bit snapshot format.
+ * @throws std::range_error if it does not fit.
+ */
+std::uint32_t to_snapshot_index(size_t value)
+{
+    if (value > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::range_error("INF is too large for a snapshot");
+    }
+
+    return static_cast<std::uint32_t>(value);
+}
+
+/**
+ * @brief Tokenize an open INF through SetupAPI and write its snapshot.
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * concurrent readers never observe a partial snapshot. A failed rename is
+ * not an error: the caller re-validates the target.
+ *
+ * @throws std::exception on Win32, parsing or I/O failures.
+ */
+void write_snapshot(
+    const inf_file& inf,
+    const sha256_digest& source,
+    const std::filesystem::path& target,
+    std::stop_token stop = {})
+{
+    std::vector<snapshot_section> sections;
+    std::vector<snapshot_line_record> lines;
+    std::vector<std::uint32_t> fields;
+    std::vector<snapshot_string> strings;
+    std::wstring pool;
+    std::unordered_map<std::wstring, std::uint32_t> interned;
+
+    auto intern = [&](std::wstring_view value)
+        {
+            auto [existing, inserted] = interned.try_emplace(std::wstring{ value }, to_snapshot_index(strings.size()));
+            if (inserted)
+            {
+                strings.push_back(snapshot_string{
+                    .offset = to_snapshot_index(pool.size()),
+                    .length = to_snapshot_index(value.size()) });
+                pool.append(value);
+            }
+
+            return existing->second;
+        };
+
+    std::vector<section_name> names;
+    inf.for_each_section([&names](section_name_view name)
+        {
+            names.emplace_back(name);
+            return enumeration::move_next;
+        }, stop);
+
+    for (const section_name& name : names)
+    {
+        snapshot_section section{
+            .name = intern(std::wstring_view{ name.data(), name.size() }),
+            .first_line = to_snapshot_index(lines.size()),
+            .line_count = 0 };
+
+        inf.for_each_line(name, [&](const line& line)
+            {
+                key_name_view key = line.key();
+                snapshot_line_record record{
+                    .key = intern(std::wstring_view{ key.data(), key.size() }),
+                    .first_field = to_snapshot_index(fields.size()),
+                    .field_count = to_snapshot_index(line.size()) };
+
+                for (std::wstring_view field : line.fields())
+                {
+                    fields.push_back(intern(field));
+                }
+
+                lines.push_back(record);
+                return enumeration::move_next;
+            }, stop);
+
+        section.line_count = to_snapshot_index(lines.size() - section.first_line);
+        sections.push_back(section);
+    }
+
+    std::vector<std::uint32_t> order(sections.size());
+    std::iota(order.begin(), order.end(), std::uint32_t{ 0 });
+    std::ranges::sort(order, std::less{}, [&](std::uint32_t index)
+        {
+            const snapshot_string& name = strings[sections[index].name];
+            return section_name_view{ pool.data() + name.offset, name.length };
+        });
+
+    // a stable sort keeps the first line of a repeated key first, which is
+    // the line SetupFindFirstLineW returns
+    std::vector<std::uint32_t> key_order(lines.size());
+    std::iota(key_order.begin(), key_order.end(), std::uint32_t{ 0 });
+    for (const snapshot_section& section : sections)
+    {
+        std::ranges::stable_sort(
+            std::span{ key_order }.subspan(section.first_line, section.line_count),
+            std::less{},
+            [&](std::uint32_t index)
+            {
+                const snapshot_string& key = strings[lines[index].key];
+                return key_name_view{ pool.data() + key.offset, key.length };
+            });
+    }
+
+    const snapshot_header header{
+        .magic = snapshot_header::expected_magic,
+        .version = snapshot_header::current_version,
+        .source = source,
+        .section_count = to_snapshot_index(sections.size()),
+        .line_count = to_snapshot_index(lines.size()),
+        .field_count = to_snapshot_index(fields.size()),
+        .string_count = to_snapshot_index(strings.size()),
+        .character_count = pool.size() };
+
+    std::filesystem::path temporary = target;
+    temporary += L".tmp";
+    temporary += std::to_wstring(std::random_device{}());
+
+    {
+        std::ofstream output{ temporary, std::ios::binary | std::ios::trunc };
+        auto write = [&output](const auto& items)
+            {
+                output.write(
+                    reinterpret_cast<const char*>(std::ranges::data(items)),
+                    static_cast<std::streamsize>(std::ranges::size(items) * sizeof(*std::ranges::data(items))));
+            };
+
+        write(std::span{ &header, 1 });
+        write(sections);
+        write(order);
+        write(lines);
+        write(key_order);
+        write(fields);
+        write(strings);
+        write(pool);
+
+        if (!output.flush())
+        {
+            throw std::runtime_error("Failed to write an INF snapshot");
+        }
+    }
+
+    // another process may have published the same snapshot meanwhile and
+    // still have it mapped; the caller validates whatever ends up in place
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+class inf_snapshot;
+
+/**
+ * @class snapshot_field_reader
+ * @brief Maps a field's string index to its text in the snapshot.
+ */
+class snapshot_field_reader
+{
+public:
+    const inf_snapshot* owner;
+
+    std::wstring_view operator()(std::uint32_t index) const;
+};
+
+/**
+ * @typedef snapshot_fields
+ * @brief Value fields of a snapshot line, read in place.
+ */
+using snapshot_fields = std::ranges::transform_view<std::span<const std::uint32_t>, snapshot_field_reader>;
+
+/**
+ * @class snapshot_line
+ * @brief `line`-compatible view of one snapshot line: `key()`, `size()`,
+ *        0-based `field_at(i)`, `fields()` and `append_fields(target, first)`,
+ *        plus their `try_*` forms. `fields()` is a random-access range rather
+ *        than a span, as the fields are read from the string table. Returned
+ *        views stay valid for the lifetime of the snapshot. A corrupted
+ *        snapshot throws from either form: it is not a fault of one line.
+ */
+class snapshot_line
+{
+private:
+    const inf_snapshot* owner;
+    const snapshot_line_record* record;
+
+    snapshot_line(const inf_snapshot& owner, const snapshot_line_record& record) noexcept
+        : owner{ &owner },
+        record{ &record }
+    {
+    }
+
+    friend class inf_snapshot;
+
+public:
+    key_name_view key() const;
+
+    std::expected<key_name_view, inf_error> try_key() const
+    {
+        return key();
+    }
+
+    size_t size() const noexcept
+    {
+        return record->field_count;
+    }
+
+    std::expected<size_t, inf_error> try_size() const noexcept
+    {
+        return size();
+    }
+
+    std::expected<std::wstring_view, inf_error> try_field_at(ptrdiff_t index) const;
+
+    std::wstring_view field_at(ptrdiff_t index) const
+    {
+        return value_or_throw(try_field_at(index));
+    }
+
+    snapshot_fields fields() const;
+
+    std::expected<snapshot_fields, inf_error> try_fields() const
+    {
+        return fields();
+    }
+
+    template <typename container>
+    void append_fields(container& target, size_t first = 0) const
+    {
+        for (std::wstring_view field : fields() | std::views::drop(first))
+        {
+            target.emplace_back(field);
+        }
+    }
+
+    template <typename container>
+    std::expected<void, inf_error> try_append_fields(container& target, size_t first = 0) const
+    {
+        append_fields(target, first);
+        return {};
+    }
+};
+
+/**
+ * @class inf_snapshot
+ * @brief Read-only INF source over a mapped `.infc` file with the
+ *        enumeration API of `inf_file`.
+ *
+ * @throws std::runtime_error for missing sections and corrupted tables.
+ */
+class inf_snapshot
+{
+private:
+    mapped_file file;
+    std::span<const snapshot_section> sections;
+    std::span<const std::uint32_t> section_order;
+    std::span<const snapshot_line_record> lines;
+    std::span<const std::uint32_t> key_order;
+    std::span<const std::uint32_t> fields;
+    std::span<const snapshot_string> strings;
+    std::wstring_view pool;
+
+    [[noreturn]] static void corrupted()
+    {
+        throw std::runtime_error("INF snapshot is corrupted");
+    }
+
+    explicit inf_snapshot(mapped_file&& mapped)
+        : file{ std::move(mapped) }
+    {
+        const std::byte* position = file.contents().data();
+        snapshot_header header;
+        std::memcpy(&header, position, sizeof(header));
+        position += sizeof(snapshot_header);
+
+        auto take = [&position]<typename T>(std::type_identity<T>, size_t count)
+            {
+                std::span<const T> table{ reinterpret_cast<const T*>(position), count };
+                position += table.size_bytes();
+                return table;
+            };
+
+        sections = take(std::type_identity<snapshot_section>{}, header.section_count);
+        section_order = take(std::type_identity<std::uint32_t>{}, header.section_count);
+        lines = take(std::type_identity<snapshot_line_record>{}, header.line_count);
+        key_order = take(std::type_identity<std::uint32_t>{}, header.line_count);
+        fields = take(std::type_identity<std::uint32_t>{}, header.field_count);
+        strings = take(std::type_identity<snapshot_string>{}, header.string_count);
+        pool = std::wstring_view{ reinterpret_cast<const wchar_t*>(position), static_cast<size_t>(header.character_count) };
+    }
+
+    const snapshot_section* try_find_section(section_name_view name) const
+    {
+        auto found = std::ranges::lower_bound(section_order, name, std::less{}, [this](std::uint32_t index)
+            {
+                return section_name_at(index);
+            });
+
+        if (found == section_order.end() || section_name_at(*found) != name)
+        {
+            return nullptr;
+        }
+
+        return &sections[*found];
+    }
+
+    const snapshot_section& find_section(section_name_view name) const
+    {
+        if (const snapshot_section* section = try_find_section(name))
+        {
+            return *section;
+        }
+
+        throw_inf_error(inf_error::section_not_found);
+    }
+
+    section_name_view section_name_at(std::uint32_t index) const
+    {
+        if (index >= sections.size())
+        {
+            corrupted();
+        }
+
+        std::wstring_view name = string_at(sections[index].name);
+        return section_name_view{ name.data(), name.size() };
+    }
+
+    key_name_view key_at(std::uint32_t index) const
+    {
+        if (index >= lines.size())
+        {
+            corrupted();
+        }
+
+        std::wstring_view key = string_at(lines[index].key);
+        return key_name_view{ key.data(), key.size() };
+    }
+
+    std::span<const snapshot_line_record> lines_of(const snapshot_section& section) const
+    {
+        if (section.first_line > lines.size() || section.line_count > lines.size() - section.first_line)
+        {
+            corrupted();
+        }
+
+        return lines.subspan(section.first_line, section.line_count);
+    }
+
+    friend class snapshot_line;
+    friend class snapshot_field_reader;
+
+public:
+    /**
+     * @brief Map and validate a snapshot in O(1).
+     * @return The snapshot, or `std::nullopt` if the file is missing, cannot
+     *         be mapped, is not a snapshot of this version, or was made from
+     *         different content.
+     */
+    static std::optional<inf_snapshot> open(const std::filesystem::path& path, const sha256_digest& source)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(path, error))
+        {
+            return std::nullopt;
+        }
+
+        // a snapshot locked or being replaced by another process cannot be
+        // mapped; like a stale one, it is rebuilt
+        std::optional<mapped_file> opened;
+        try
+        {
+            opened.emplace(path);
+        }
+        catch (const std::exception&)
+        {
+            return std::nullopt;
+        }
+
+        mapped_file mapped{ std::move(*opened) };
+        std::span<const std::byte> content = mapped.contents();
+        if (content.size() < sizeof(snapshot_header))
+        {
+            return std::nullopt;
+        }
+
+        snapshot_header header;
+        std::memcpy(&header, content.data(), sizeof(header));
+
+        const std::uint64_t expected_size = sizeof(snapshot_header)
+            + std::uint64_t{ header.section_count } * (sizeof(snapshot_section) + sizeof(std::uint32_t))
+            + std::uint64_t{ header.line_count } * (sizeof(snapshot_line_record) + sizeof(std::uint32_t))
+            + std::uint64_t{ header.field_count } * sizeof(std::uint32_t)
+            + std::uint64_t{ header.string_count } * sizeof(snapshot_string);
+
+        if (header.magic != snapshot_header::expected_magic
+            || header.version != snapshot_header::current_version
+            || header.source != source
+            || header.character_count > (std::numeric_limits<std::uint64_t>::max() - expected_size) / sizeof(wchar_t)
+            || expected_size + header.character_count * sizeof(wchar_t) != content.size())
+        {
+            return std::nullopt;
+        }
+
+        return inf_snapshot{ std::move(mapped) };
+    }
+
+    std::wstring_view string_at(std::uint32_t index) const
+    {
+        if (index >= strings.size())
+        {
+            corrupted();
+        }
+
+        const snapshot_string& item = strings[index];
+        if (item.offset > pool.size() || item.length > pool.size() - item.offset)
+        {
+            corrupted();
+        }
+
+        return pool.substr(item.offset, item.length);
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, section_name_view>
+    void for_each_section(F&& section_name_handler, std::stop_token stop = {}) const
+    {
+        for (std::uint32_t index = 0; index < sections.size(); ++index)
+        {
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
+            if (section_name_handler(section_name_at(index)) == enumeration::stop)
+            {
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, const snapshot_line&>
+    void for_each_line(section_name_view section_name, F&& key_value_handler, std::stop_token stop = {}) const
+    {
+        for (const snapshot_line_record& record : lines_of(find_section(section_name)))
+        {
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
+            if (key_value_handler(snapshot_line{ *this, record }) == enumeration::stop)
+            {
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, section_name_view>
+    std::expected<void, inf_error> try_for_each_section(F&& section_name_handler, std::stop_token stop = {}) const
+    {
+        for_each_section(std::forward<F>(section_name_handler), stop);
+        return {};
+    }
+
+    template <typename F>
+    requires std::is_invocable_r_v<enumeration, F, const snapshot_line&>
+    std::expected<void, inf_error> try_for_each_line(
+        section_name_view section_name,
+        F&& key_value_handler,
+        std::stop_token stop = {}) const
+    {
+        const snapshot_section* section = try_find_section(section_name);
+        if (section == nullptr)
+        {
+            return std::unexpected{ inf_error::section_not_found };
+        }
+
+        for (const snapshot_line_record& record : lines_of(*section))
+        {
+            if (stop.stop_requested())
+            {
+                throw operation_cancelled{};
+            }
+
+            if (key_value_handler(snapshot_line{ *this, record }) == enumeration::stop)
+            {
+                return {};
+            }
+        }
+
+        return {};
+    }
+
+    bool has_section(section_name_view section) const
+    {
+        return try_find_section(section) != nullptr;
+    }
+
+    std::optional<snapshot_line> get_line(section_name_view section, key_name_view key) const
+    {
+        // `key_order` shares the line ranges of `lines`, so this validates
+        // the range in both tables
+        const snapshot_section& found_section = find_section(section);
+        lines_of(found_section);
+
+        std::span<const std::uint32_t> order = key_order.subspan(found_section.first_line, found_section.line_count);
+        auto found = std::ranges::lower_bound(order, key, std::less{}, [this](std::uint32_t index)
+            {
+                return key_at(index);
+            });
+
+        if (found == order.end() || key_at(*found) != key)
+        {
+            return std::nullopt;
+        }
+
+        return snapshot_line{ *this, lines[*found] };
+    }
+};
+
+key_name_view snapshot_line::key() const
+{
+    std::wstring_view key = owner->string_at(record->key);
+    return key_name_view{ key.data(), key.size() };
+}
+
+std::wstring_view snapshot_field_reader::operator()(std::uint32_t index) const
+{
+    return owner->string_at(index);
+}
+
+snapshot_fields snapshot_line::fields() const
+{
+    if (size_t{ record->first_field } + record->field_count > owner->fields.size())
+    {
+        inf_snapshot::corrupted();
+    }
+
+    return snapshot_fields{ owner->fields.subspan(record->first_field, record->field_count), snapshot_field_reader{ owner } };
+}
+
+std::expected<std::wstring_view, inf_error> snapshot_line::try_field_at(ptrdiff_t index) const
+{
+    if (index < 0 || static_cast<size_t>(index) >= size())
+    {
+        return std::unexpected{ inf_error::field_out_of_range };
+    }
+
+    const size_t position = size_t{ record->first_field } + static_cast<size_t>(index);
+    if (position >= owner->fields.size())
+    {
+        inf_snapshot::corrupted();
+    }
+
+    return owner->string_at(owner->fields[position]);
+}
+
+/**
+ * @brief Read an INF through its snapshot in a cache directory, building
+ *        the snapshot through SetupAPI first if it is missing or unusable.
+ *
+ * Snapshots are named `<sha256-of-source>.infc`. `source` was computed
+ * before SetupAPI reads the INF, which may have changed in between; once
+ * the INF is open (SetupAPI loads it whole on open) it is hashed again, and
+ * when it no longer matches `source` nothing is cached and `use` gets the
+ * open INF instead, so a snapshot always holds the content it is named
+ * after.
+ *
+ * @param inf_path Source INF.
+ * @param source SHA-256 of the source INF content.
+ * @param cache_directory Directory holding the snapshots; created if needed.
+ * @param use Callable receiving the `const inf_snapshot&`, or the
+ *        `const inf_file&` when the INF changed.
+ * @param stop Cancels building a missing snapshot.
+ * @throws std::exception on Win32, parsing or I/O failures.
+ */
+template <typename F>
+void with_cached_inf(
+    const std::filesystem::path& inf_path,
+    const sha256_digest& source,
+    const std::filesystem::path& cache_directory,
+    F&& use,
+    std::stop_token stop = {})
+{
+    std::filesystem::path snapshot_path = cache_directory / std::filesystem::path{ to_hex(source) };
+    snapshot_path += L".infc";
+
+    if (std::optional<inf_snapshot> snapshot = inf_snapshot::open(snapshot_path, source))
+    {
+        use(*snapshot);
+        return;
+    }
+
+    const inf_file inf{ inf_path };
+    if (sha256(mapped_file{ inf_path }.contents()) != source)
+    {
+        use(inf);
+        return;
+    }
+
+    std::filesystem::create_directories(cache_directory);
+    write_snapshot(inf, source, snapshot_path, stop);
+
+    if (std::optional<inf_snapshot> snapshot = inf_snapshot::open(snapshot_path, source))
+    {
+        use(*snapshot);
+        return;
+    }
+
+    throw std::runtime_error("Failed to load a freshly written INF snapshot");
+}
@@ -0,0 +1,360 @@
+/**
+ * @file parse_limits_test.cpp
+ * @brief Scaling and cap tests for `check_parse_limits` and
+ *        `select_report_data` on synthetic pathological INFs.
+ *
+ * Each shape the parse limits exist for is generated at two sizes, four
+ * times apart: one logical line made of `\` continuations, one line of
+ * `%strkey%` tokens, and one `[Manufacturer]` line with many decorations.
+ * Both sizes must pass the default limits and report every ID and
+ * architecture, and each cap must reject an INF just over it.
+ *
+ * With `--timing`, both the limit check and a full report must also take
+ * at most twice the linear time on the larger INF; a quadratic step would
+ * take 16 times as long. Wall-clock ratios are noisy on loaded machines, so
+ * that check is a separate CTest test, only registered on request.
+ *
+ * Exits with 0 when every check passes; failures are printed to stderr.
+ */
+
+#include <iostream>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <ranges>
+#include <generator>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <expected>
+#include <functional>
+#include <stop_token>
+#include <span>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <exception>
+#include <utility>
+#include <chrono>
+#include <array>
+#include <charconv>
+#include <cctype>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+import setup_api;
+
+#include "reader.h"
+#include "hardware_id.h"
+#include "report.h"
+#include "parse_limits.h"
+
+namespace
+{
+    constexpr size_t small_size{ 200 };
+    constexpr size_t size_scale{ 4 };
+
+    // a linear step takes `size_scale` times as long on the larger INF;
+    // this leaves room for timer noise and cache effects
+    constexpr double max_time_ratio{ 2.0 * size_scale };
+
+    int failures{ 0 };
+
+    void expect(bool condition, std::string_view what)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << what << '\n';
+            ++failures;
+        }
+    }
+
+    /**
+     * @class synthetic_inf
+     * @brief A generated INF and what its report must contain.
+     */
+    class synthetic_inf
+    {
+    public:
+        std::string text;
+        size_t hardware_ids;
+        size_t architectures;
+    };
+
+    const std::string_view inf_header =
+        "[Version]\r\n"
+        "Signature=\"$Windows NT$\"\r\n"
+        "Class=System\r\n";
+
+    const std::string_view inf_strings =
+        "[Strings]\r\n"
+        "Mfg=\"Contoso\"\r\n"
+        "Dev=\"Contoso Device\"\r\n";
+
+    /**
+     * @brief One device and a `[Notes]` line joined from `count` physical
+     *        lines by `\` continuations.
+     */
+    synthetic_inf make_continuation_inf(size_t count)
+    {
+        std::string text{ inf_header };
+        text += "[Manufacturer]\r\n%Mfg%=Models\r\n";
+        text += "[Models]\r\n%Dev%=Install,ROOT\\CONTOSO\r\n";
+        text += "[Notes]\r\nNote=";
+        for (size_t piece = 0; piece < count; ++piece)
+        {
+            text += "abcdefghijklmno\\\r\n";
+        }
+
+        text += "end\r\n";
+        text += inf_strings;
+        return synthetic_inf{ .text = std::move(text), .hardware_ids = 1, .architectures = 1 };
+    }
+
+    /**
+     * @brief One device whose `count` hardware IDs are all `%strkey%`
+     *        tokens.
+     */
+    synthetic_inf make_token_inf(size_t count)
+    {
+        std::string text{ inf_header };
+        text += "[Manufacturer]\r\n%Mfg%=Models\r\n";
+        text += "[Models]\r\n%Dev%=Install";
+        for (size_t token = 0; token < count; ++token)
+        {
+            text += std::format(",%Id{}%", token);
+        }
+
+        text += "\r\n";
+        text += inf_strings;
+        for (size_t token = 0; token < count; ++token)
+        {
+            text += std::format("Id{0}=\"ROOT\\CONTOSO_{0}\"\r\n", token);
+        }
+
+        return synthetic_inf{ .text = std::move(text), .hardware_ids = count, .architectures = 1 };
+    }
+
+    /**
+     * @brief One device listed under `count` decorations, each with its own
+     *        models section.
+     */
+    synthetic_inf make_decoration_inf(size_t count)
+    {
+        std::string text{ inf_header };
+        text += "[Manufacturer]\r\n%Mfg%=Models";
+        for (size_t decoration = 0; decoration < count; ++decoration)
+        {
+            text += std::format(",NTamd64.{}", decoration);
+        }
+
+        text += "\r\n";
+        for (size_t decoration = 0; decoration < count; ++decoration)
+        {
+            text += std::format("[Models.NTamd64.{}]\r\n%Dev%=Install,ROOT\\CONTOSO\r\n", decoration);
+        }
+
+        text += inf_strings;
+        return synthetic_inf{ .text = std::move(text), .hardware_ids = 1, .architectures = count };
+    }
+
+    std::span<const std::byte> bytes_of(std::string_view text) noexcept
+    {
+        return std::as_bytes(std::span{ text });
+    }
+
+    /**
+     * @brief Encode ASCII text as UTF-16LE with a byte order mark.
+     */
+    std::string to_utf16_file(std::string_view text)
+    {
+        std::string result{ "\xFF\xFE" };
+        for (const char c : text)
+        {
+            result += c;
+            result += '\0';
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Best time of one call over a few batches, each long enough to
+     *        be measured.
+     */
+    template <typename F>
+    double seconds_per_call(F operation)
+    {
+        using clock = std::chrono::steady_clock;
+        static constexpr auto batch_time = std::chrono::milliseconds{ 20 };
+        static constexpr int batches{ 5 };
+
+        double best{ std::numeric_limits<double>::max() };
+        for (int batch = 0; batch < batches; ++batch)
+        {
+            size_t calls{ 0 };
+            const clock::time_point start = clock::now();
+            clock::duration elapsed{};
+            do
+            {
+                operation();
+                ++calls;
+                elapsed = clock::now() - start;
+            } while (elapsed < batch_time);
+
+            best = std::min(best, std::chrono::duration<double>(elapsed).count() / static_cast<double>(calls));
+        }
+
+        return best;
+    }
+
+    void expect_linear(std::string_view what, double smaller_time, double larger_time)
+    {
+        const double ratio = larger_time / smaller_time;
+        std::cout << std::format("{}: {:.3f} ms -> {:.3f} ms (x{:.1f})\n", what, smaller_time * 1e3, larger_time * 1e3, ratio);
+        expect(ratio <= max_time_ratio, std::format("{} grows faster than linearly (x{:.1f})", what, ratio));
+    }
+
+    /**
+     * @brief Write an INF to a temporary file, removed on destruction.
+     */
+    class temporary_inf
+    {
+    public:
+        std::filesystem::path path;
+
+        temporary_inf(std::string_view name, std::string_view text)
+            : path(std::filesystem::temp_directory_path() / std::format("parse_limits_test_{}.inf", name))
+        {
+            std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+            output.write(text.data(), static_cast<std::streamsize>(text.size()));
+            if (!output)
+            {
+                throw std::runtime_error("Failed to write a test INF");
+            }
+        }
+
+        ~temporary_inf()
+        {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+
+        temporary_inf(const temporary_inf&) = delete;
+        temporary_inf& operator=(const temporary_inf&) = delete;
+    };
+
+    report parse_inf(const std::filesystem::path& path)
+    {
+        inf_file inf{ path };
+        return select_report_data(inf);
+    }
+
+    /**
+     * @brief Check that an INF is accepted with the default limits and
+     *        reports one device of the expected shape.
+     */
+    void expect_report(std::string_view what, const synthetic_inf& inf, const std::filesystem::path& path)
+    {
+        try
+        {
+            check_parse_limits(bytes_of(inf.text), parse_limits{});
+        }
+        catch (const limit_exceeded& e)
+        {
+            expect(false, std::format("{} is rejected by the default limits: {}", what, e.what()));
+            return;
+        }
+
+        const report output = parse_inf(path);
+        const bool one_device = output.size() == 1 && output.front().devices.size() == 1;
+        expect(one_device, std::format("{} reports one device", what));
+        if (one_device)
+        {
+            const model& device = output.front().devices.front();
+            expect(device.hardware_ids.size() == inf.hardware_ids, std::format("{} reports every hardware ID", what));
+            expect(device.architectures.size() == inf.architectures, std::format("{} reports every architecture", what));
+        }
+    }
+
+    void test_scaling(std::string_view name, synthetic_inf (*generate)(size_t), bool timing)
+    {
+        const synthetic_inf smaller = generate(small_size);
+        const synthetic_inf larger = generate(small_size * size_scale);
+        const temporary_inf smaller_file{ std::format("{}_small", name), smaller.text };
+        const temporary_inf larger_file{ std::format("{}_large", name), larger.text };
+
+        expect_report(std::format("{} ({})", name, small_size), smaller, smaller_file.path);
+        expect_report(std::format("{} ({})", name, small_size * size_scale), larger, larger_file.path);
+        if (!timing)
+        {
+            return;
+        }
+
+        expect_linear(
+            std::format("check_parse_limits, {}", name),
+            seconds_per_call([&] { check_parse_limits(bytes_of(smaller.text), parse_limits{}); }),
+            seconds_per_call([&] { check_parse_limits(bytes_of(larger.text), parse_limits{}); }));
+
+        expect_linear(
+            std::format("select_report_data, {}", name),
+            seconds_per_call([&] { parse_inf(smaller_file.path); }),
+            seconds_per_call([&] { parse_inf(larger_file.path); }));
+    }
+
+    void expect_exceeded(std::string_view what, std::span<const std::byte> content, const parse_limits& limits)
+    {
+        try
+        {
+            check_parse_limits(content, limits);
+            expect(false, std::format("{} is over its limit but accepted", what));
+        }
+        catch (const limit_exceeded&)
+        {
+        }
+    }
+
+    void test_caps()
+    {
+        static constexpr size_t count{ 100 };
+
+        const std::string continued = make_continuation_inf(count).text;
+        const std::string tokens = make_token_inf(count).text;
+        const std::string decorations = make_decoration_inf(count).text;
+
+        expect_exceeded("file size", bytes_of(continued), parse_limits{ .max_file_size = continued.size() - 1 });
+
+        // every physical line is short; only the joined line is over
+        expect_exceeded("continued line length", bytes_of(continued), parse_limits{ .max_line_length = count * 8 });
+        expect_exceeded(
+            "continued UTF-16 line length",
+            bytes_of(to_utf16_file(continued)),
+            parse_limits{ .max_line_length = count * 8 });
+
+        expect_exceeded("fields", bytes_of(decorations), parse_limits{ .max_fields = count / 2 });
+        expect_exceeded("substitutions", bytes_of(tokens), parse_limits{ .max_substitutions = count / 2 });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool timing = argc > 1 && std::string_view{ argv[1] } == "--timing";
+
+    try
+    {
+        test_caps();
+        test_scaling("continuations", make_continuation_inf, timing);
+        test_scaling("tokens", make_token_inf, timing);
+        test_scaling("decorations", make_decoration_inf, timing);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "FAILED: " << e.what() << '\n';
+        return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
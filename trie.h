@@ -0,0 +1,553 @@
+/**
+ * @file trie.h
+ * @brief In-memory hardware-ID index answering prefix and glob queries such
+ *        as `PCI\VEN_8086&DEV_*` over one or many reports.
+ *
+ * Hardware IDs are folded with `fold_key` and stored in a path-compressed
+ * radix trie: every node owns the label of the edge leading to it, children
+ * are kept sorted by their first byte, and a node that ends an ID holds its
+ * posting list. Queries walk only the subtrees the pattern can still match
+ * and report IDs in ordinal order.
+ */
+
+/**
+ * @class hardware_id_posting
+ * @brief One occurrence of a hardware ID: indices of the corpus entry, its
+ *        manufacturer, the device and the ID within the device.
+ */
+class hardware_id_posting
+{
+public:
+    std::uint32_t entry;
+    std::uint32_t manufacturer;
+    std::uint32_t device;
+    std::uint32_t hardware_id;
+};
+
+/**
+ * @class glob_automaton
+ * @brief Bit-parallel NFA of a glob pattern: bit `p` of a state set is live
+ *        when a prefix of the key matches the first `p` pattern bytes.
+ *
+ * A step over one key byte is a few word operations: live positions whose
+ * byte (or `?`) matches move one bit up, and `*` positions stay live. Runs
+ * of `*` are collapsed first, so a star is always followed by a literal
+ * position and one shift makes the position after a live star live too.
+ */
+class glob_automaton
+{
+public:
+    static constexpr size_t max_pattern{ 255 };
+
+    using state_set = std::array<std::uint64_t, (max_pattern + 1 + 63) / 64>;
+
+private:
+    std::array<state_set, 256> matching{};
+    state_set stars{};
+    size_t length{ 0 };
+    size_t words{ 1 };
+
+    state_set shift_up(const state_set& states) const noexcept
+    {
+        state_set result{};
+        std::uint64_t carry{ 0 };
+        for (size_t word = 0; word < words; ++word)
+        {
+            result[word] = (states[word] << 1) | carry;
+            carry = states[word] >> 63;
+        }
+
+        return result;
+    }
+
+    static void set(state_set& states, size_t position) noexcept
+    {
+        states[position / 64] |= std::uint64_t{ 1 } << (position % 64);
+    }
+
+    /**
+     * @brief Make the position after every live star live: a star may
+     *        match nothing.
+     */
+    void close(state_set& states) const noexcept
+    {
+        state_set live_stars{};
+        for (size_t word = 0; word < words; ++word)
+        {
+            live_stars[word] = states[word] & stars[word];
+        }
+
+        const state_set skipped = shift_up(live_stars);
+        for (size_t word = 0; word < words; ++word)
+        {
+            states[word] |= skipped[word];
+        }
+    }
+
+public:
+    /**
+     * @throws std::length_error if the pattern, with runs of `*`
+     *         collapsed, is longer than `max_pattern` bytes.
+     */
+    explicit glob_automaton(std::string_view pattern)
+    {
+        for (size_t position = 0; position < pattern.size(); ++position)
+        {
+            const char c = pattern[position];
+            if (c == '*' && position != 0 && pattern[position - 1] == '*')
+            {
+                continue;
+            }
+
+            if (length == max_pattern)
+            {
+                throw std::length_error("The glob pattern is too long");
+            }
+
+            if (c == '*')
+            {
+                set(stars, length);
+            }
+            else if (c == '?')
+            {
+                for (state_set& states : matching)
+                {
+                    set(states, length);
+                }
+            }
+            else
+            {
+                set(matching[static_cast<unsigned char>(c)], length);
+            }
+
+            ++length;
+        }
+
+        words = length / 64 + 1;
+    }
+
+    state_set start() const noexcept
+    {
+        state_set states{};
+        set(states, 0);
+        close(states);
+        return states;
+    }
+
+    /**
+     * @brief Advance the live positions over one key byte.
+     * @return `false` when no position is live anymore.
+     */
+    bool step(state_set& states, char c) const noexcept
+    {
+        const state_set& accepted = matching[static_cast<unsigned char>(c)];
+
+        // nearly every pattern fits in one word
+        if (words == 1)
+        {
+            const std::uint64_t current = states[0];
+            std::uint64_t next = ((current & accepted[0]) << 1) | (current & stars[0]);
+            next |= (next & stars[0]) << 1;
+            states[0] = next;
+            return next != 0;
+        }
+
+        state_set moved{};
+        for (size_t word = 0; word < words; ++word)
+        {
+            moved[word] = states[word] & accepted[word];
+        }
+
+        moved = shift_up(moved);
+        for (size_t word = 0; word < words; ++word)
+        {
+            states[word] = moved[word] | (states[word] & stars[word]);
+        }
+
+        close(states);
+
+        std::uint64_t live{ 0 };
+        for (size_t word = 0; word < words; ++word)
+        {
+            live |= states[word];
+        }
+
+        return live != 0;
+    }
+
+    /**
+     * @brief Whether every continuation of the key matches: the pattern
+     *        ends with `*` and that star is live.
+     */
+    bool accepts_any_suffix(const state_set& states) const noexcept
+    {
+        const size_t last = length - 1;
+        return length != 0
+            && (stars[last / 64] >> (last % 64) & 1) != 0
+            && (states[last / 64] >> (last % 64) & 1) != 0;
+    }
+
+    /**
+     * @brief Whether the whole pattern has been matched.
+     */
+    bool accepts(const state_set& states) const noexcept
+    {
+        return (states[length / 64] >> (length % 64) & 1) != 0;
+    }
+};
+
+/**
+ * @class hardware_id_trie
+ * @brief Path-compressed, case-folded radix trie of hardware IDs.
+ */
+class hardware_id_trie
+{
+private:
+    static constexpr std::uint32_t root{ 0 };
+
+    class node
+    {
+    public:
+        std::string label;
+        std::vector<std::uint32_t> children;
+        std::vector<hardware_id_posting> postings;
+    };
+
+    std::vector<node> nodes{ 1 };
+    size_t key_count{ 0 };
+
+    /**
+     * @brief Find the child whose label starts with `first`, or the position
+     *        where such a child would be inserted.
+     */
+    std::vector<std::uint32_t>::iterator child_position(std::uint32_t parent, char first)
+    {
+        return std::ranges::lower_bound(nodes[parent].children, first, std::less{},
+            [this](std::uint32_t child) { return nodes[child].label.front(); });
+    }
+
+    /**
+     * @brief Find the child whose label starts with `first`.
+     */
+    std::optional<std::uint32_t> child_starting_with(std::uint32_t parent, char first) const
+    {
+        const auto& children = nodes[parent].children;
+        auto position = std::ranges::lower_bound(children, first, std::less{},
+            [this](std::uint32_t child) { return nodes[child].label.front(); });
+
+        return position != children.end() && nodes[*position].label.front() == first
+            ? std::optional{ *position }
+            : std::nullopt;
+    }
+
+    std::uint32_t add_node(std::string label)
+    {
+        nodes.push_back(node{ .label = std::move(label), .children = {}, .postings = {} });
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
+
+    template <typename F>
+    void visit_matches(
+        std::uint32_t current,
+        const glob_automaton& pattern,
+        glob_automaton::state_set states,
+        std::string& key,
+        F& sink) const
+    {
+        if (pattern.accepts_any_suffix(states))
+        {
+            visit_subtree(current, key, sink);
+            return;
+        }
+
+        const node& item = nodes[current];
+        for (char c : item.label)
+        {
+            if (!pattern.step(states, c))
+            {
+                return;
+            }
+        }
+
+        const size_t key_size = key.size();
+        key += item.label;
+
+        if (!item.postings.empty() && pattern.accepts(states))
+        {
+            sink(std::string_view{ key }, std::span<const hardware_id_posting>{ item.postings });
+        }
+
+        for (std::uint32_t child : item.children)
+        {
+            visit_matches(child, pattern, states, key, sink);
+        }
+
+        key.resize(key_size);
+    }
+
+    template <typename F>
+    void visit_subtree(std::uint32_t current, std::string& key, F& sink) const
+    {
+        const node& item = nodes[current];
+
+        const size_t key_size = key.size();
+        key += item.label;
+
+        if (!item.postings.empty())
+        {
+            sink(std::string_view{ key }, std::span<const hardware_id_posting>{ item.postings });
+        }
+
+        for (std::uint32_t child : item.children)
+        {
+            visit_subtree(child, key, sink);
+        }
+
+        key.resize(key_size);
+    }
+
+public:
+    /**
+     * @brief Add an occurrence of a hardware ID.
+     * @param folded ID already folded with `fold_key`; empty IDs are ignored.
+     */
+    void insert(std::string_view folded, const hardware_id_posting& posting)
+    {
+        if (folded.empty())
+        {
+            return;
+        }
+
+        std::uint32_t current = root;
+        while (true)
+        {
+            if (folded.empty())
+            {
+                if (nodes[current].postings.empty())
+                {
+                    ++key_count;
+                }
+
+                nodes[current].postings.push_back(posting);
+                return;
+            }
+
+            auto position = child_position(current, folded.front());
+            const size_t offset = static_cast<size_t>(position - nodes[current].children.begin());
+            if (position == nodes[current].children.end() || nodes[*position].label.front() != folded.front())
+            {
+                const std::uint32_t leaf = add_node(std::string{ folded });
+                nodes[current].children.insert(nodes[current].children.begin() + offset, leaf);
+                nodes[leaf].postings.push_back(posting);
+                ++key_count;
+                return;
+            }
+
+            const std::uint32_t child = *position;
+            const size_t common = static_cast<size_t>(
+                std::ranges::mismatch(nodes[child].label, folded).in1 - nodes[child].label.begin());
+
+            if (common < nodes[child].label.size())
+            {
+                // split the edge: the shared part becomes a new node between
+                // `current` and `child`
+                const std::uint32_t middle = add_node(nodes[child].label.substr(0, common));
+                nodes[child].label.erase(0, common);
+                nodes[middle].children.push_back(child);
+                nodes[current].children[offset] = middle;
+                current = middle;
+            }
+            else
+            {
+                current = child;
+            }
+
+            folded.remove_prefix(common);
+        }
+    }
+
+    /**
+     * @brief Number of distinct folded IDs.
+     */
+    size_t size() const noexcept
+    {
+        return key_count;
+    }
+
+    /**
+     * @brief Postings of exactly one ID.
+     * @param folded Folded ID.
+     * @return The postings; empty when the ID is not indexed.
+     */
+    std::span<const hardware_id_posting> find(std::string_view folded) const
+    {
+        std::uint32_t current = root;
+        while (!folded.empty())
+        {
+            const std::optional<std::uint32_t> child = child_starting_with(current, folded.front());
+            if (!child.has_value() || !folded.starts_with(nodes[*child].label))
+            {
+                return {};
+            }
+
+            folded.remove_prefix(nodes[*child].label.size());
+            current = *child;
+        }
+
+        return nodes[current].postings;
+    }
+
+    /**
+     * @brief Report every ID starting with `prefix`, in ordinal order.
+     * @param prefix Folded prefix; matched literally.
+     * @param sink Callable receiving `(std::string_view folded_id,
+     *        std::span<const hardware_id_posting>)`.
+     */
+    template <typename F>
+    requires std::is_invocable_v<F&, std::string_view, std::span<const hardware_id_posting>>
+    void find_prefix(std::string_view prefix, F&& sink) const
+    {
+        std::uint32_t current = root;
+        std::string key;
+        while (!prefix.empty())
+        {
+            const std::optional<std::uint32_t> child = child_starting_with(current, prefix.front());
+            if (!child.has_value())
+            {
+                return;
+            }
+
+            const std::string_view label = nodes[*child].label;
+            const size_t common = std::min(label.size(), prefix.size());
+            if (label.substr(0, common) != prefix.substr(0, common))
+            {
+                return;
+            }
+
+            if (common == prefix.size())
+            {
+                visit_subtree(*child, key, sink);
+                return;
+            }
+
+            key += label;
+            prefix.remove_prefix(common);
+            current = *child;
+        }
+
+        visit_subtree(current, key, sink);
+    }
+
+    /**
+     * @brief Report every ID matching a glob pattern, in ordinal order.
+     *
+     * `*` matches any run of bytes and `?` a single byte (hardware IDs are
+     * ASCII in practice). Subtrees are pruned as soon as no pattern position
+     * is live, so a literal prefix only visits its own subtree, and a
+     * subtree reached through a live trailing `*` is reported without
+     * stepping the pattern any further.
+     *
+     * @param pattern Folded pattern.
+     * @param sink As for `find_prefix`.
+     * @throws std::length_error if the pattern is longer than
+     *         `glob_automaton::max_pattern`.
+     */
+    template <typename F>
+    requires std::is_invocable_v<F&, std::string_view, std::span<const hardware_id_posting>>
+    void find_matching(std::string_view pattern, F&& sink) const
+    {
+        const auto automaton = std::make_unique<const glob_automaton>(pattern);
+
+        std::string key;
+        for (std::uint32_t child : nodes[root].children)
+        {
+            visit_matches(child, *automaton, automaton->start(), key, sink);
+        }
+    }
+};
+
+/**
+ * @brief Index the hardware and compatible IDs of every parsed entry.
+ */
+hardware_id_trie build_hardware_id_trie(const corpus& entries)
+{
+    hardware_id_trie result;
+    for (size_t entry = 0; entry < entries.size(); ++entry)
+    {
+        if (!entries[entry].manufacturers.has_value())
+        {
+            continue;
+        }
+
+        const report& manufacturers = *entries[entry].manufacturers;
+        for (size_t maker = 0; maker < manufacturers.size(); ++maker)
+        {
+            const std::vector<model>& devices = manufacturers[maker].devices;
+            for (size_t device = 0; device < devices.size(); ++device)
+            {
+                const std::vector<std::string>& hardware_ids = devices[device].hardware_ids;
+                for (size_t id = 0; id < hardware_ids.size(); ++id)
+                {
+                    result.insert(fold_key(hardware_ids[id]), hardware_id_posting{
+                        .entry = static_cast<std::uint32_t>(entry),
+                        .manufacturer = static_cast<std::uint32_t>(maker),
+                        .device = static_cast<std::uint32_t>(device),
+                        .hardware_id = static_cast<std::uint32_t>(id) });
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @class hardware_id_occurrence
+ * @brief A resolved posting. Views point into the corpus.
+ */
+class hardware_id_occurrence
+{
+public:
+    std::string_view inf;
+    std::string_view manufacturer;
+    const model* device;
+};
+
+/**
+ * @class hardware_id_match
+ * @brief One matching ID with all of its occurrences. `hardware_id` is the
+ *        spelling of the first occurrence.
+ */
+class hardware_id_match
+{
+public:
+    std::string_view hardware_id;
+    std::vector<hardware_id_occurrence> occurrences;
+};
+
+/**
+ * @brief Resolve the posting list of a matching ID against its corpus.
+ */
+hardware_id_match resolve_postings(const corpus& entries, std::span<const hardware_id_posting> postings)
+{
+    hardware_id_match result;
+    result.occurrences.reserve(postings.size());
+    for (const hardware_id_posting& posting : postings)
+    {
+        const corpus_entry& entry = entries[posting.entry];
+        const manufacturer& maker = (*entry.manufacturers)[posting.manufacturer];
+        const model& device = maker.devices[posting.device];
+
+        if (result.occurrences.empty())
+        {
+            result.hardware_id = device.hardware_ids[posting.hardware_id];
+        }
+
+        result.occurrences.push_back(hardware_id_occurrence{
+            .inf = entry.path,
+            .manufacturer = maker.name,
+            .device = &device });
+    }
+
+    return result;
+}